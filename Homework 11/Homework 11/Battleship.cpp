@@ -1,10 +1,52 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
 #include <ctime>
+#include <deque>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+	#include <io.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <sys/mman.h>
+	#include <sys/socket.h>
+	#include <sys/stat.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+#ifdef __linux__
+	#include <sys/epoll.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define USE_SSE2		//Every x64 CPU has SSE2, so it's only missing on old 32 bit builds and other architectures
+#endif
+
 using std::cin;
 using std::cout;
 using std::endl;
@@ -16,14 +58,9 @@ using std::string;
 
 using std::vector;
 
-const bool allowDebugCommands = true;	//Controls whether or not debug commands may be turned on
-bool debugCommandsOn = false;			//Controls if debug commands are turned on
-
-//Some debug flags
-bool debug_forceRun = false;
-bool debug_showShips = false;
+const bool allowDebugCommands = true;	//Controls whether or not debug commands may be turned on (on the console; they are never allowed in games served over a socket)
 
-int generatorLoopNum = 0;		//Used to track the number of times the gameBoard generator has looped, used in debugging
+std::atomic<int> generatorLoopNum(0);		//Used to track the number of times the gameBoard generator has looped, used in debugging
 
 enum gameState_type		//The current state the game is in
 {
@@ -33,12 +70,12 @@ enum gameState_type		//The current state the game is in
 	win,				//The player has won
 	lose,				//The player has lost
 	quitting,			//The player has requested the program quit
-} gameState;
+};
 
 struct coordi	//A coordinate pair of integers
 {
-	coordi::coordi() {}
-	coordi::coordi(int _x, int _y)
+	coordi() {}
+	coordi(int _x, int _y)
 	{
 		x = _x;
 		y = _y;
@@ -47,24 +84,24 @@ struct coordi	//A coordinate pair of integers
 	int x;
 	int y;
 
-	coordi operator+(coordi & other)
+	coordi operator+(const coordi & other)
 	{
 		return coordi(x + other.x, y + other.y);
 	}
 
-	coordi operator+=(coordi & other)
+	coordi operator+=(const coordi & other)
 	{
 		x += other.x;
 		y += other.y;
 		return *this;
 	}
 
-	bool operator==(coordi & other)
+	bool operator==(const coordi & other) const
 	{
 		return (x == other.x) && (y == other.y);
 	}
 
-	bool operator!=(coordi & other)
+	bool operator!=(const coordi & other) const
 	{
 		return (x != other.x) || (y != other.y);
 	}
@@ -93,13 +130,19 @@ enum shotResult {		//The possible outcomes of the player firing a shot
 	alreadyFired,
 };
 
-enum errorstates {			//Various errors that can be thrown 
+enum errorstates {			//Various errors that can be returned (see outcome_type)
 	noerror,			//No error
 	file_notFound,		//reading from file - file not found
 	file_eof,			//reading from file - file ended too soon (but the error was recovered from, missing data replaced with empty space)
 	file_eof_fatal,		//reading from file - file ended too soon (couldn't recover from)
 	file_lineTooShort,	//reading from file - line too short (but the error was recovered from, missing data replaced with empty space)
 	file_lineTooLong,	//reading from file - line too long (but the error was recovered from, missing data replaced with empty space)
+	file_badFormat,		//reading from file - the file isn't a binary level, or its contents are invalid
+	file_badVersion,	//reading from file - the binary level was written by a different version of the format
+	file_badSize,		//reading from file - the binary level's dimensions don't match the amount of data in it
+	file_shipsTouching,	//reading from file - two ships touch each other (but they were told apart as well as possible)
+	file_shipBent,		//reading from file - a ship isn't a straight line (but it was split into straight ships)
+	file_writeFailed,	//writing to file - the file could not be written
 
 	buffer_xToSmall,	//Screen buffer - x value for size is too small
 	buffer_yToSmall,	//Screen buffer - y value for size is too small
@@ -115,76 +158,24 @@ enum errorstates {			//Various errors that can be thrown
 
 	board_gen_shipExists,	//Game board - board generator - generator attempted to place a ship over another (isn't really an error, but is used to loop if this happens)
 
-	rand_badBounds,		//utilities::rand(), min is greater than or equal to max (no valid values)
+	board_gen_noRoom,		//Game board - board generator - the fleet could not be fit onto the board
+
+	board_staleSnapshot,	//Game board - the snapshot can't be rolled back to: the board has been replaced since, or rolled back to before it
+
+	solver_tooLarge,		//Posterior solver - the board, a ship or the fleet is too big to solve, or it has too many placements to count
+
+	rand_badBounds,		//utilities::rand(), min is greater than max (no valid values)
 };
 
-enum class ASCII		//ASCII characters and their associated integer numbers
+template <typename value_type> struct outcome_type		//The result of something that can fail: the value it produced, or the error that stopped it.  Errors are returned rather than thrown, so a failure costs no more than a success
 {
-	ZERO = 48,
-	ONE = 49,
-	TWO = 50,
-	THREE = 51,
-	FOUR = 52,
-	FIVE = 53,
-	SIX = 54,
-	SEVEN = 55,
-	EIGHT = 56,
-	NINE = 57,
-
-	A = 65,
-	B = 66,
-	C = 67,
-	D = 68,
-	E = 69,
-	F = 70,
-	G = 71,
-	H = 72,
-	I = 73,
-	J = 74,
-	K = 75,
-	L = 76,
-	M = 77,
-	N = 78,
-	O = 79,
-	P = 80,
-	Q = 81,
-	R = 82,
-	S = 83,
-	T = 84,
-	U = 85,
-	V = 86,
-	W = 87,
-	X = 88,
-	Y = 89,
-	Z = 90,
-
-	a = 97,
-	b = 98,
-	c = 99,
-	d = 100,
-	e = 101,
-	f = 102,
-	g = 103,
-	h = 104,
-	i = 105,
-	j = 106,
-	k = 107,
-	l = 108,
-	m = 109,
-	n = 110,
-	o = 111,
-	p = 112,
-	q = 113,
-	r = 114,
-	s = 115,
-	t = 116,
-	u = 117,
-	v = 118,
-	w = 119,
-	x = 120,
-	y = 121,
-	z = 122,
+	value_type value = value_type();	//Only meaningful when ok()
+	errorstates error = noerror;
 
+	outcome_type(value_type _value) : value(_value) {}
+	outcome_type(errorstates _error) : error(_error) {}
+
+	bool ok() const { return error == noerror; }
 };
 
 namespace utilities
@@ -223,39 +214,76 @@ namespace utilities
 
 			case shot_miss:
 				return 'M';
+
+			case null:
+			case invalid_cell:
+				break;
 		}
 
 		return toChar(ocean);	//Returns an ocean tile as a last resort/error recovery method
 	}
 
-	vector<cellContents_type> extractCellsFromString(string str)	//Extracts data from 'str' and converts it to a vector of 'cellContents_type' elements.  Ignores spaces.
+	struct commandTokens_type		//The words of a command, as views into the line they came from.  Fixed size, so splitting a command never allocates
 	{
-		vector<cellContents_type> data;
-		for(auto iter = str.begin(); iter != str.end(); iter++)
+		static const int maxTokens = 8;		//No command uses more than a few words, anything past this is ignored
+
+		std::string_view tokens[maxTokens];
+		int count = 0;
+
+		size_t size() const { return size_t(count); }
+		std::string_view operator[](int i) const { return tokens[i]; }
+	};
+
+	void tokenize(std::string_view line, commandTokens_type & command)		//Splits 'line' into words separated by spaces (i.e. "A  B C" -> {A,B,C}).  'line' has to outlive 'command'
+	{
+		command.count = 0;
+
+		size_t i = 0;
+		while(i < line.size() && command.count < commandTokens_type::maxTokens)
 		{
-			if(*iter != ' ') data.push_back(toCellType(*iter));
+			while(i < line.size() && line[i] == ' ') i++;		//Skip the spaces before the word
+			if(i == line.size()) break;
+
+			size_t end = i;
+			while(end < line.size() && line[end] != ' ') end++;
+
+			command.tokens[command.count++] = line.substr(i, end - i);
+			i = end;
 		}
-		return data;
 	}
 
-	vector<string> separateStringsBySpaces(string str)		//Separates a string into a vector of strings, using spaces as separators (i.e. "A B C" -> {a,b,c})
-	{
-		vector<string> ret;	//The extracted data
+	bool parseInt(std::string_view text, int & value)		//Reads 'text' as a whole number (digits, with an optional leading '-').  Returns false, leaving 'value' alone, if it isn't one or doesn't fit in an int
+	{	//Like std::from_chars, but the whole of 'text' has to be the number
+		size_t i = 0;
+		bool negative = false;
+		if(i < text.size() && text[i] == '-')
+		{
+			negative = true;
+			i++;
+		}
+		if(i == text.size()) return false;
 
-		string data = "";	//The current segment of data
+		long long result = 0;
+		for(; i < text.size(); i++)
+		{
+			if(text[i] < '0' || '9' < text[i]) return false;
+			result = result * 10 + (text[i] - '0');
+			if(result > 2147483648LL) return false;
+		}
 
-		for(auto iter = str.begin(); iter != str.end(); iter++)	//Loop over every element in the string
+		if(negative) result = -result;
+		if(result > 2147483647LL) return false;
+
+		value = int(result);
+		return true;
+	}
+
+	void toLowerInPlace(string & input)		//Converts input to lowercase, without copying it
+	{
+		for(size_t i = 0; i < input.size(); i++)
 		{
-			if(*iter == ' ')	//If the character reached is a space, move the current segment to the extracted data array, and reset the extracted data string
-			{
-				ret.push_back(data);
-				data = "";
-			}
-			else data.push_back(*iter);
+			input[i] = char(tolower((unsigned char) input[i]));
 		}
-		if(data != "") ret.push_back(data);	//If the data we have itsn't none, add it to the extracted data vector
-		
-		return ret;
 	}
 
 	string errorStateToString(errorstates err)		//Returns the string equivalent of some exceptions, to print them to the screen
@@ -280,6 +308,24 @@ namespace utilities
 			case file_lineTooLong:
 				return "File: The line was longer than expected.";
 
+			case file_badFormat:
+				return "File: The file is not a valid binary level.";
+
+			case file_badVersion:
+				return "File: The binary level is from an unsupported version.";
+
+			case file_badSize:
+				return "File: The binary level's size does not match its contents.";
+
+			case file_shipsTouching:
+				return "File: Two ships are touching.";
+
+			case file_shipBent:
+				return "File: A ship is not a straight line.";
+
+			case file_writeFailed:
+				return "File: The file could not be written.";
+
 			case buffer_xToSmall:
 				return "Screen buffer: Attempted to create a buffer with width < 1";
 
@@ -294,6 +340,33 @@ namespace utilities
 
 			case convert_fail_intStr:
 				return "Data conversion: Integer -> String: Conversion failed.";
+
+			case convert_fail_strInt:
+				return "Data conversion: String -> Integer: Conversion failed.";
+
+			case convert_fail_charInt:
+				return "Data conversion: Character -> Integer: The character is not a digit.";
+
+			case board_badX:
+				return "Game board: The column is not on the board.";
+
+			case board_badY:
+				return "Game board: The row is not on the board.";
+
+			case board_gen_shipExists:
+				return "Board generator: There is already a ship there.";
+
+			case rand_badBounds:
+				return "Random numbers: The lower bound is greater than the upper bound.";
+
+			case board_gen_noRoom:
+				return "Board generator: The fleet does not fit on the game board.";
+
+			case board_staleSnapshot:
+				return "Game board: The snapshot is from a board that has since been replaced or rolled back past.";
+
+			case solver_tooLarge:
+				return "Posterior solver: The board or fleet is too large to solve, or there are too many ways to place it.";
 		}
 
 		return "Unknown error.";
@@ -301,956 +374,7248 @@ namespace utilities
 
 	string toString(int value)		//Converts an integer to a string
 	{
-		string ret;
-
-		std::stringstream convert;
-		convert << value;
-		convert >> ret;
-
-		if(convert.fail()) throw convert_fail_intStr;
+		return std::to_string(value);
+	}
 
-		return ret;
+	outcome_type<int> toNum(char inp)		//Converts a digit to a number.  Fails with convert_fail_charInt if 'inp' isn't a digit
+	{
+		if(inp < '0' || '9' < inp) return convert_fail_charInt;
+		return inp - '0';
 	}
 
-	double toNum(char inp, bool noFail = false)		//Converts a char to a number.  Doesn't throw any exceptions if noFail == true 
+	coordi toStep(direction_type direction)		//Returns the change in position of one step in 'direction'
 	{
-		double ret;
+		switch(direction)
+		{
+			case north:
+				return coordi(0, -1);
 
-		std::stringstream convert;
-		convert << inp;
-		convert >> ret;
+			case south:
+				return coordi(0, 1);
 
-		if(convert.fail() && noFail == false) throw convert_fail_charInt;
+			case east:
+				return coordi(1, 0);
 
-		return ret;
+			case west:
+				return coordi(-1, 0);
+		}
+		return coordi(0, 0);
 	}
 
-	double toNum(string inp)	//Converts a string to a number
+	bool isCharLetter(char inp)	//Is the character 'inp'  a->z or A->Z
 	{
-		double ret;
+		inp = tolower(inp);
+		return 'a' <= inp && inp <= 'z';
+	}
 
-		std::stringstream convert;
-		convert << inp;
-		convert >> ret;
+	bool parseCoordinate(std::string_view text, coordi & pos)	//Reads a firing coordinate, a column name then a number (i.e. "b4" -> (1, 4), "aa10" -> (26, 10)).  Returns false if 'text' isn't one.  Doesn't check that it's on the board
+	{	//Columns are named like spreadsheet columns: A to Z, then AA to AZ, BA and so on
+		size_t letters = 0;
+		int column = 0;
+		while(letters < text.size() && letters < 6 && isCharLetter(text[letters]))		//6 letters is more columns than a board can have
+		{
+			column = column * 26 + (tolower((unsigned char) text[letters]) - 'a' + 1);
+			letters++;
+		}
 
-		if(convert.fail()) throw convert_fail_strInt;
+		int number;
+		if(letters == 0 || !parseInt(text.substr(letters), number)) return false;
 
-		return ret;
+		pos = coordi(column - 1, number);
+		return true;
 	}
 
-	bool isNum(string inp)		//Returns whether or not inp is a number
+	string columnName(int x)	//Returns the name of column 'x' (the opposite of parseCoordinate(), i.e. 0 -> "A", 26 -> "AA")
 	{
-		try
-		{
-			toNum(inp);
-		}
-		catch(...)			//If any exception is triggered while converting 'inp' to a number, it can be assumed that 'inp' is not a number
+		string name;
+		for(x++; x > 0; x = (x - 1) / 26)
 		{
-			return false;
+			name.insert(name.begin(), char('A' + (x - 1) % 26));
 		}
+		return name;
+	}
 
-		return true;
+	uint64_t splitMix64(uint64_t & state)		//Advances 'state' and returns the next SplitMix64 output.  Used to turn one seed into many well-mixed seeds
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
 	}
 
-	string toLower(string input)	//Converts input to lowercase
+	class random_type		//A seedable random number generator (xoshiro256**).  Each thread/worker gets its own, so nothing is shared between threads
 	{
-		for(int i = 0; i < input.size(); i++)
+		uint64_t state[4];
+
+		static uint64_t rotl(uint64_t value, int k) { return (value << k) | (value >> (64 - k)); }
+
+	public:
+		random_type(uint64_t seed = 0) { setSeed(seed); }
+
+		void setSeed(uint64_t seed)		//Restarts the sequence.  The same seed always produces the same sequence
 		{
-			input[i] = tolower(input[i]);
+			for(int i = 0; i < 4; i++)
+			{
+				state[i] = splitMix64(seed);
+			}
 		}
-		return input;
+
+		uint64_t next()		//Returns the next 64 random bits
+		{
+			const uint64_t result = rotl(state[1] * 5, 7) * 9;
+			const uint64_t t = state[1] << 17;
+
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = rotl(state[3], 45);
+
+			return result;
+		}
+
+		uint64_t below(uint64_t range)		//Returns a random number in [0, range) without the bias of next() % range.  'range' must not be 0
+		{	//Lemire's multiply-and-shift method: the top 64 bits of next() * range, rejecting the few values that would make some results more likely than others
+		#if defined(__SIZEOF_INT128__)
+			unsigned __int128 product = (unsigned __int128) next() * range;
+			uint64_t low = uint64_t(product);
+			if(low < range)
+			{
+				const uint64_t threshold = (0 - range) % range;
+				while(low < threshold)
+				{
+					product = (unsigned __int128) next() * range;
+					low = uint64_t(product);
+				}
+			}
+			return uint64_t(product >> 64);
+		#else
+			//No 128-bit multiply (MSVC), so use rejection on the largest multiple of 'range' instead
+			const uint64_t limit = (0 - range) % range;		//2^64 mod range, values below this are rejected
+			uint64_t value;
+			do { value = next(); } while(value < limit);
+			return value % range;
+		#endif
+		}
+
+		int range(int lower, int higher)	//Returns a random number between 'lower' and 'higher' (inclusive).  'lower' must not be greater than 'higher' (see utilities::rand() for a checked version)
+		{
+			return lower + int(below(uint64_t(int64_t(higher) - lower) + 1));
+		}
+	};
+
+	random_type & threadRandom()		//The random number generator used by the thread that calls this
+	{
+		//Seeded from the time and the thread, so every thread gets a different sequence unless seedRandom() is called
+		thread_local random_type random(uint64_t(std::time(NULL)) ^ (uint64_t(std::hash<std::thread::id>()(std::this_thread::get_id())) << 16));
+		return random;
 	}
 
-	bool isCharLetter(char inp)	//Is the character 'inp'  a->z or A->Z
+	void seedRandom(uint64_t seed)		//Seeds the calling thread's random number generator
 	{
-		inp = tolower(inp);
-		return 'a' <= inp && inp <= 'z';
+		threadRandom().setSeed(seed);
+	}
+
+	outcome_type<int> rand(int lower, int higher)		//Returns a random number between 'lower' and 'higher' (inclusive).  Fails with rand_badBounds if there is no such number
+	{
+		if(lower > higher) return rand_badBounds;
+		return threadRandom().range(lower, higher);
+	}
+
+	int popcount(uint64_t value);
+
+	int countTrailingZeros(uint64_t value)		//Returns the index of the lowest set bit in 'value' ('value' must not be 0)
+	{
+	#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(value);
+	#else
+		return popcount((value & (~value + 1)) - 1);		//Isolate the lowest bit, and count the bits below it
+	#endif
+	}
+
+	int highestBit(uint64_t value)		//Returns the index of the highest set bit in 'value' ('value' must not be 0)
+	{
+	#if defined(__GNUC__) || defined(__clang__)
+		return 63 - __builtin_clzll(value);
+	#else
+		int index = 0;
+		while(value >>= 1) index++;
+		return index;
+	#endif
 	}
 
-	bool isCharNum(char inp)	//Is the character 'inp' the CHARACTER for 0->9, NOT if the char ID is 0->9
+	const uint64_t * byteMasks()		//Returns a table of 256 words, where byte k of word b is 0xFF if bit k of b is set and 0 if it isn't.  Turns 8 bits into 8 byte masks with one lookup
 	{
-		return (int) ASCII::ZERO <= inp && (int) inp <= (int) ASCII::NINE;
+		static const vector<uint64_t> table = []()
+		{
+			vector<uint64_t> masks(256, 0);
+			for(int bits = 0; bits < 256; bits++)
+			{
+				for(int k = 0; k < 8; k++)
+				{
+					if(bits & (1 << k)) masks[bits] |= uint64_t(0xFF) << (8 * k);
+				}
+			}
+			return masks;
+		}();
+		return &table[0];
 	}
 
-	int rand(int lower, int higher)		//Returns a random number between 'lower' and 'higher' (inclusive)
+	int selectBit(uint64_t value, int n)		//Returns the index of the 'n'th (counting from 0) set bit in 'value'
 	{
-		if(lower >= higher) throw rand_badBounds;
-		return std::rand() % (higher - lower + 1) + lower;
+		for(int i = 0; i < n; i++)
+		{
+			value &= value - 1;		//Clear the lowest set bit
+		}
+		return countTrailingZeros(value);
 	}
 
-	//Returns the sign of 'val'
-	template <typename T> int sgn(T val) {
-		//Returns -1 when val < 0, 0 when val = 0, and 1 when val > 0
-		//Credit to https://stackoverflow.com/questions/1903954/is-there-a-standard-sign-function-signum-sgn-in-c-c
-		return (T(0) < val) - (val < T(0));
+	int popcount(uint64_t value)	//Returns the number of bits set in 'value'
+	{
+	#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_popcountll(value);
+	#else
+		//SWAR popcount, works on every compiler/platform (including Win32 builds where __popcnt64 isn't available)
+		value = value - ((value >> 1) & 0x5555555555555555ULL);
+		value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+		value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return int((value * 0x0101010101010101ULL) >> 56);
+	#endif
 	}
 };
 
 namespace util = utilities;		//Creates a shortcut for utilities
 
-void clearConsole()		//Clears the console
-{
-	system("cls");
-}
+using utilities::random_type;
 
-class screenBuffer_type		//The buffer characters are written to before they are written to the screen.  Used to only change portions of the screen, keeping other parts the same
-{
-	coordi size;
-	vector<vector<char>> buffer;
+namespace profiling		//Timers and counters for the hot parts of the game, turned on and off with the #profile debug command.  When off, a timer costs one flag check
+{	//Timings go into a histogram per phase (safe to use from several threads at once), so the typical (p50) and the worst (p99) times can be reported, not just the average
+	typedef std::chrono::steady_clock clock_type;
 
-public:
-	void setSize(coordi _size)	//Sets the size of the buffer, and expands/shrinks the buffer to that size
+	enum phase_type		//The parts of the game that are timed
 	{
-		if(_size.x < 1) throw buffer_xToSmall;
-		if(_size.y < 1) throw buffer_yToSmall;
-		size = _size;
+		phase_input,		//Splitting up and parsing a typed command (not waiting for it)
+		phase_fire,			//gameBoard_type::fire()
+		phase_winCheck,		//gameBoard_type::checkWinLoss()
+		phase_print,		//gameBoard_type::print()
+		phase_push,			//screenBuffer_type::pushToConsole()
+		phase_generate,		//Placing a fleet on a board
+		phase_load,			//Loading a level file
+		phaseCount
+	};
+
+	const char * const phaseNames[phaseCount] = { "input parsing", "fire", "win check", "board print", "push to console", "board generation", "level loading" };
+
+	enum counter_type
+	{
+		counter_consoleBytes,	//Bytes written to the console
+		counter_levelBytes,		//Bytes of level files loaded
+		counterCount
+	};
+
+	const char * const counterNames[counterCount] = { "console bytes written", "level bytes loaded" };
+
+	std::atomic<bool> enabled(false);
 
-		//While the buffer is larger than it should be
-		while(size.x < buffer.size())
+	class histogram_type		//A histogram of durations in nanoseconds.  Each power of two is split into 4 buckets, so a percentile is within 25% of the real value
+	{
+		static const int subBuckets = 4;
+		static const int bucketCount = 64 * subBuckets;
+
+		std::atomic<uint64_t> buckets[bucketCount];
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> total;
+		std::atomic<uint64_t> longest;
+
+		static int bucketOf(uint64_t nanoseconds)
 		{
-			buffer.pop_back();
+			if(nanoseconds < subBuckets) return int(nanoseconds);
+			const int top = util::highestBit(nanoseconds);
+			return top * subBuckets + int((nanoseconds >> (top - 2)) & (subBuckets - 1));
 		}
 
-		//While the buffer is smaller than it should be
-		while(size.x > buffer.size())
+		static uint64_t bucketLimit(int bucket)		//The largest duration that lands in 'bucket'
 		{
-			buffer.push_back(vector<char>());
+			if(bucket < subBuckets) return uint64_t(bucket);
+			const int top = bucket / subBuckets;
+			return ((uint64_t(subBuckets + bucket % subBuckets) + 1) << (top - 2)) - 1;
 		}
 
-		for(int i = 0; i < buffer.size(); i++)
+	public:
+		histogram_type() { reset(); }
+
+		void reset()
 		{
-			//While the number of elements is larger than it should be
-			while(size.y < buffer[i].size())
-			{
-				buffer[i].pop_back();
-			}
+			for(int i = 0; i < bucketCount; i++) buckets[i] = 0;
+			count = 0;
+			total = 0;
+			longest = 0;
+		}
 
-			//While the number of elements is smaller than it should be
-			while(size.y > buffer[i].size())
-			{
-				buffer[i].push_back(' ');
-			}
+		void record(uint64_t nanoseconds)
+		{
+			buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+			count.fetch_add(1, std::memory_order_relaxed);
+			total.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+			uint64_t seen = longest.load(std::memory_order_relaxed);
+			while(nanoseconds > seen && !longest.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {}
 		}
-	}
 
-	void pushToConsole()	//Exports the data from the buffer to the console
-	{
-		clearConsole();
-		for(int y = 0; y < size.y; y++)
+		uint64_t getCount() { return count; }
+		uint64_t getLongest() { return longest; }
+		double mean() { return count > 0 ? double(total) / double(count) : 0; }
+
+		uint64_t percentile(double fraction)		//Returns the duration 'fraction' of the recorded durations were within
 		{
-			for(int x = 0; x < size.x; x++)
+			const uint64_t wanted = uint64_t(fraction * double(count));
+			uint64_t seen = 0;
+			for(int i = 0; i < bucketCount; i++)
 			{
-				std::cout << buffer[x][y];
+				seen += buckets[i];
+				if(seen > wanted || (seen == count && seen > 0)) return std::min(bucketLimit(i), getLongest());
 			}
-			std::cout << std::endl;
+			return 0;
 		}
+	};
+
+	histogram_type histograms[phaseCount];
+	std::atomic<long long> counters[counterCount];
+
+	void count(counter_type counter, long long amount)		//Adds 'amount' to 'counter', if profiling is on
+	{
+		if(enabled.load(std::memory_order_relaxed)) counters[counter].fetch_add(amount, std::memory_order_relaxed);
 	}
 
-	void write(coordi pos, char value, bool noFail = false)	//Writes a character ('value') to the buffer at 'pos', if noFail == true, the function will not throw any exceptions
+	class scopedTimer_type		//Times from when it's created until it's destroyed, and adds the time to its phase's histogram
 	{
-		if(!(0 <= pos.x && pos.x < size.x))
+		phase_type phase;
+		bool timing;
+		clock_type::time_point start;
+
+	public:
+		scopedTimer_type(phase_type _phase) : phase(_phase), timing(enabled.load(std::memory_order_relaxed))
 		{
-			if(noFail) return;
-			else throw buffer_write_badX;
+			if(timing) start = clock_type::now();
 		}
-		if(!(0 <= pos.y && pos.y < size.y))
+
+		~scopedTimer_type()
 		{
-			if(noFail) return;
-			else throw buffer_write_badY;
+			if(timing) histograms[phase].record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count()));
 		}
 
-		buffer[pos.x][pos.y] = value;
+		scopedTimer_type(const scopedTimer_type &) = delete;
+		scopedTimer_type & operator=(const scopedTimer_type &) = delete;
+	};
+
+	void reset()		//Clears every histogram and counter
+	{
+		for(int i = 0; i < phaseCount; i++) histograms[i].reset();
+		for(int i = 0; i < counterCount; i++) counters[i] = 0;
+		generatorLoopNum = 0;
 	}
 
-	void write(coordi pos, string value, bool noFail = false)	//Writes a string ('value') to the buffer, starting at 'pos'
-		//If noFail == true, the function will not throw any exceptions, and instead will write as much as it can, giving up if it cannot do something
+	void report(std::ostream & out)		//Prints the timings and counters gathered so far to 'out'
 	{
-		for(int i = 0; i < value.size(); i++)
+		char line[128];
+		snprintf(line, sizeof(line), "%-18s %10s %10s %10s %10s %10s", "phase (us)", "count", "mean", "p50", "p99", "max");
+		out << line << endl;
+
+		for(int i = 0; i < phaseCount; i++)
 		{
-			write(pos + coordi(i, 0), value[i], noFail);
+			histogram_type & histogram = histograms[i];
+			snprintf(line, sizeof(line), "%-18s %10llu %10.2f %10.2f %10.2f %10.2f", phaseNames[i], (unsigned long long) histogram.getCount(), histogram.mean() / 1000,
+				histogram.percentile(0.5) / 1000.0, histogram.percentile(0.99) / 1000.0, histogram.getLongest() / 1000.0);
+			out << line << endl;
 		}
-	}
 
-	void clearRow(int y, char clearWith = ' ')		//Replaces an entire row with 'clearWidth', which is a space by default
-	{
-		for(int x = 0; x < size.x; x++)
+		out << endl;
+		for(int i = 0; i < counterCount; i++)
 		{
-			buffer[x][y] = clearWith;
+			out << counterNames[i] << ": " << counters[i] << endl;
 		}
+		out << "generator retries: " << generatorLoopNum << endl;
 	}
 };
 
-screenBuffer_type screen;
+void writeToConsole(const char * data, size_t length)	//Writes 'data' straight to the console, in as few write() calls as the OS allows (normally one)
+{
+	cout.flush();		//Anything still waiting in cout has to get there first
+
+	while(length > 0)
+	{
+	#ifdef _WIN32
+		int written = _write(1, data, unsigned(length));
+	#else
+		ssize_t written = ::write(1, data, length);
+	#endif
+		if(written <= 0) return;
+		data += written;
+		length -= size_t(written);
+	}
+}
+
+void enableConsoleEscapes()		//The screen is drawn with ANSI escape sequences, which the Windows console only understands once they're turned on
+{
+#ifdef _WIN32
+	HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD mode = 0;
+	if(GetConsoleMode(console, &mode)) SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#endif
+}
+
+class screenBuffer_type		//The buffer characters are written to before they are written to the screen.  Used to only change portions of the screen, keeping other parts the same
+{
+	coordi size = coordi(0, 0);
+	vector<char> buffer;			//The characters, row after row: buffer[y * size.x + x]
+
+	vector<char> front;				//What is on the console right now (as far as we know), laid out like 'buffer', so only the differences need to be sent
+	bool frontValid = false;		//False when the console's contents are unknown
 
-class gameBoard_type		//A game board.  Set up as a class so 2-person play is possible (not currently implimented), and also to add data validation functions (i.e. don't let things read/write to [-1, 6], etc)
-{							//The board also contains some other gameplay data, i.e. number of shots remaining
 public:
-	gameBoard_type::gameBoard_type(coordi boardSize) {	//Creates a new gameBoard element with 'size' dimensions
-		size = boardSize;
+	errorstates setSize(coordi _size)	//Sets the size of the buffer, and expands/shrinks the buffer to that size.  Whatever was already written is kept where it still fits
+	{	//Returns buffer_xToSmall/buffer_yToSmall (and leaves the buffer alone) if '_size' is less than 1x1
+		if(_size.x < 1) return buffer_xToSmall;
+		if(_size.y < 1) return buffer_yToSmall;
 
-		//Trim or expand the x-axis to size
-		while(board.size() > size.x)
-		{
-			//Remove columns from the end of the x-axis vector
-			board.pop_back();
-		}
-		while(board.size() < size.x)
-		{
-			//Add empty columns to the x-axis vector
-			board.push_back(vector<cellContents_type>());
-		}
+		vector<char> resized(size_t(_size.x) * _size.y, ' ');
 
-		//Iterate over the x-axis
-		for(auto iter = board.begin(); iter != board.end(); iter++)
+		const int keepX = std::min(size.x, _size.x);
+		for(int y = 0; y < std::min(size.y, _size.y); y++)
 		{
-			//Trim or expand the elements in each of the y-axies to the proper size
-			while(iter->size() > size.y)
-			{
-				//Remove elements from the the end of the y vector
-				iter->pop_back();
-			}
-			while(iter->size() < size.y)
-			{
-				//Add elements to the y vector
-				iter->push_back(ocean);
-			}
+			std::memcpy(&resized[size_t(y) * _size.x], &buffer[size_t(y) * size.x], keepX);
 		}
+
+		buffer.swap(resized);
+		size = _size;
+		frontValid = false;
+		return noerror;
 	}
 
-private:
-	vector<vector<cellContents_type>> board;	//The game board, indexed by x and y coordinates
-	coordi size;								//The dimensions of the game board
+	coordi getSize() { return size; }
 
-	int shotsMax = 60;	//The maximum number of shots the player can take
-	int shots = shotsMax;		//The number of shots the player has left
+	char * row(int y) { return &buffer[size_t(y) * size.x]; }		//Returns the first character of row 'y'.  Does NOT check that 'y' is in the buffer
 
-	//File loader flags
-	vector<errorstates> fileErrors;
+	void invalidate() { frontValid = false; }	//Forgets what is on the console, so the next frame redraws everything.  Needed whenever something else writes to the console
 
-public:
-	void emptyBoard()		//Empties the game board.  WILL RESULT IN DATA LOSS (duh)
+	void composeFrame(string & frame)	//Appends the escape sequences and characters that bring the console from 'front' to 'buffer' to 'frame', and updates 'front'
 	{
-		//Empty the data from the board
-		while(board.size() > 0) board.pop_back();
+		if(!frontValid || front.size() != buffer.size())
+		{
+			frame += "\x1b[2J";	//Clear the screen, everything gets drawn below
+			front.assign(buffer.size(), '\0');	//Nothing matches '\0', so every cell is redrawn
+		}
 
-		//Repopulate the board with null cells spaces
+		coordi cursor(-1, -1);		//Where the console's cursor will be, (-1, -1) when unknown
+		char position[32];
+
+		for(int y = 0; y < size.y; y++)
 		{
-			vector<cellContents_type> column;	//An empty column
+			const char * next = &buffer[size_t(y) * size.x];
+			char * shown = &front[size_t(y) * size.x];
 
-			//Expand the empty column 'template' to the proper size
-			for(int i = 0; i < size.y; i++)
-			{
-				column.push_back(null);
-			}
+			if(std::memcmp(next, shown, size.x) == 0) continue;		//Most rows don't change from frame to frame
 
-			//Insert the empty column into the x-vector to build the chart to the proper width
-			for(int i = 0; i < size.x; i++)
+			for(int x = 0; x < size.x; x++)
 			{
-				board.push_back(column);
+				if(next[x] == shown[x]) continue;
+
+				if(cursor.x != x || cursor.y != y)	//Only move the cursor when the changed cells aren't next to each other
+				{
+					snprintf(position, sizeof(position), "\x1b[%d;%dH", y + 1, x + 1);
+					frame += position;
+				}
+
+				frame += next[x];
+				shown[x] = next[x];
+				cursor = coordi(x + 1, y);
 			}
 		}
 
-	}
+		//Leave the cursor on the line below the screen, and clear whatever was typed there last time
+		snprintf(position, sizeof(position), "\x1b[%d;1H\x1b[J", size.y + 1);
+		frame += position;
 
-	coordi getBoardSize() { return size; }
+		frontValid = true;
+	}
 
-	bool isValidPosition(coordi pos)		//Returns true when 'pos' is a valid position within the game board
+	errorstates write(coordi pos, char value)	//Writes a character ('value') to the buffer at 'pos'.  Returns buffer_write_badX/buffer_write_badY (and writes nothing) if 'pos' is off the buffer
 	{
-		return (0 <= pos.x && pos.x < size.x) && (0 <= pos.y && pos.y < size.y);
+		if(!(0 <= pos.x && pos.x < size.x)) return buffer_write_badX;
+		if(!(0 <= pos.y && pos.y < size.y)) return buffer_write_badY;
+
+		writeUnchecked(pos, value);
+		return noerror;
 	}
 
-	cellContents_type getContents(coordi pos)	//Returns the contents of a cell, after making sure that the cell is valid
+	void writeUnchecked(coordi pos, char value) { buffer[size_t(pos.y) * size.x + pos.x] = value; }		//Writes 'value' at 'pos', which the caller has already made sure is on the buffer
+
+	errorstates writeSpan(coordi pos, const char * data, int length, bool noFail = false)	//Writes 'length' characters from 'data' to the buffer, starting at 'pos'
+		//If noFail == true, the part that fits in the buffer is written and nothing is reported.  Otherwise nothing is written unless all of it fits, and buffer_write_badX/buffer_write_badY is returned
 	{
-		if(!(0 <= pos.x && pos.x < size.x)) throw board_badX;
-		if(!(0 <= pos.y && pos.y < size.y)) throw board_badY;
-		return board[pos.x][pos.y];
+		if(!(0 <= pos.y && pos.y < size.y)) return (noFail ? noerror : buffer_write_badY);
+
+		int first = 0;			//The range of 'data' that lands inside the buffer
+		int last = length;
+		if(pos.x < 0) first = -pos.x;
+		if(pos.x + length > size.x) last = size.x - pos.x;
+
+		if(!noFail && (first > 0 || last < length)) return buffer_write_badX;
+		if(first >= last) return noerror;
+
+		std::memcpy(&buffer[size_t(pos.y) * size.x + pos.x + first], data + first, last - first);
+		return noerror;
 	}
 
-	void setContents(coordi pos, cellContents_type cell)
+	errorstates write(coordi pos, const string & value, bool noFail = false)	//Writes a string ('value') to the buffer, starting at 'pos'
+		//If noFail == true, as much as fits is written and nothing is reported, otherwise see writeSpan()
 	{
-		if(!(0 <= pos.x && pos.x < size.x)) throw board_badX;
-		if(!(0 <= pos.y && pos.y < size.y)) throw board_badY;
-		board[pos.x][pos.y] = cell;
+		return writeSpan(pos, value.data(), int(value.size()), noFail);
 	}
 
-	//Places a ship of 'length' at 'startingPoint' in 'direction'
-	void createShip(coordi startingPoint, direction_type direction = north, int length = 1)
+	void clearRow(int y, char clearWith = ' ')		//Replaces an entire row with 'clearWidth', which is a space by default
 	{
-		coordi size(0, 0);		//The 'size' of the ship, with 'startingPoint' as the origin
+		if(!(0 <= y && y < size.y)) return;
+		std::memset(&buffer[size_t(y) * size.x], clearWith, size.x);
+	}
+};
 
-		switch(direction)
-		{
-			case north:
-				size.y = -length;
-				break;
+class bitBoard_type		//Packed storage for the cells of a game board.  Every cell is one bit in each of three planes (ship, hit, miss)
+{						//Boards of up to maxDenseWords words are dense: all of the planes live in one contiguous allocation, each stored row-major with every row padded out to a whole
+						//number of 64-bit words, so a row can be processed a word at a time.  Bigger boards are sparse: they are cut into tiles of 64 x 16 cells, and only the tiles that
+						//have been written to are stored (found through a hash map), so untouched ocean costs no memory.  Within a tile, each plane is one word per row
+public:
+	enum plane_type
+	{
+		shipPlane,		//Set when there is a ship (destroyed or not) in the cell
+		hitPlane,		//Set when the ship in the cell has been hit
+		missPlane,		//Set when a shot has landed in the cell and hit nothing
+		planeCount
+	};
 
-			case east:
-				size.x = length;
-				break;
+	static const int bitsPerWord = 64;
+	static const int tileRows = 16;				//The height of a tile on a sparse board (its width is one word)
+	static const int maxDenseWords = 1 << 20;	//The most words (8 MB, about 2900 x 2900 cells) a board can use before it is stored sparsely
 
-			case south:
-				size.y = length;
-				break;
+	struct tile_type		//The cells of one tile of a sparse board, words[plane][y % tileRows], with cell x in bit x % 64
+	{
+		coordi position = coordi(0, 0);			//The tile's place on the board: its column (x / 64) and row (y / tileRows)
+		uint64_t words[planeCount][tileRows] = {};
+	};
 
-			case west:
-				size.x = -length;
-				break;
-		}
+private:
+	coordi size = coordi(0, 0);	//The dimensions of the board, in cells
+	int rowWords = 0;			//The number of words used to store one row of one plane
+	bool sparse = false;		//True if the board is stored as tiles rather than as whole planes
 
-		coordi pos = startingPoint;		//The current point
+	vector<uint64_t> words;		//The planes of a dense board, one after another: words[(plane * size.y + y) * rowWords + x / 64]
 
-		do		//loop util pos == startingPoint + size, checking for other ships
-		{
-			if(getContents(pos) == ship)
-			{
-				generatorLoopNum;
-				throw board_gen_shipExists;
-			}
+	vector<tile_type> tiles;						//The tiles of a sparse board that have been written to, in the order they were first written
+	std::unordered_map<uint64_t, int> tileIndex;	//The index in 'tiles' of each of them, by tileKey()
 
-			pos += coordi(util::sgn(size.x), util::sgn(size.y));	//Incriment pos in the proper direction
-		} while(pos != startingPoint + size);
+	int wordIndex(int plane, int x, int y) const { return (plane * size.y + y) * rowWords + (x >> 6); }	//x >> 6 == x / bitsPerWord
 
-		pos = startingPoint;
+	static uint64_t tileKey(int tileX, int tileY) { return (uint64_t(uint32_t(tileY)) << 32) | uint32_t(tileX); }
 
-		do		//loop util pos == startingPoint + size, placing ship elements
-		{
-			setContents(pos, ship);
-
-			pos += coordi(util::sgn(size.x), util::sgn(size.y));	//Incriment pos in the proper direction
-		}
-		while(pos != startingPoint + size);
+	int findTile(int tileX, int tileY) const		//Returns the index in 'tiles' of the tile at (tileX, tileY), or -1 if it hasn't been written to (and so is all ocean)
+	{
+		auto found = tileIndex.find(tileKey(tileX, tileY));
+		return (found == tileIndex.end() ? -1 : found->second);
 	}
 
-	void createShip(int length)		//Randomly places a ship of 'length'
+	tile_type & useTile(int tileX, int tileY)		//Returns the tile at (tileX, tileY), adding it (as ocean) if it hasn't been written to yet
 	{
-		direction_type dir = direction_type(util::rand(0, 3));
-
-		int xMin = (dir == west ? length : 0);
-		int xMax = (dir == east ? size.x - length : size.x - 1);
-		int yMin = (dir == north ? length : 0);
-		int yMax = (dir == south ? size.y - length : size.y - 1);
-
-		coordi pos = coordi(util::rand(xMin, xMax), util::rand(yMin, yMax));
-
-		createShip(pos, dir, length);
+		int index = findTile(tileX, tileY);
+		if(index >= 0) return tiles[index];
+
+		index = int(tiles.size());
+		tiles.push_back(tile_type());
+		tiles.back().position = coordi(tileX, tileY);
+		tileIndex[tileKey(tileX, tileY)] = index;
+		return tiles.back();
 	}
 
-	int getShots() { return shots; }
-
-	void setShots(int value, bool force = false)	//Sets the number of shots remaining to 'value', if value > 0.  if 'force' == true the input validation is ovveridden
+	//The sparse halves of getCell() and setCell(), kept apart so the hash map lookup doesn't slow down the dense boards every normal game is played on
+	cellContents_type getSparseCell(int x, int y) const
 	{
-		if(value > 0 || force) shots = value;		//If the number of shots remaning is greater than 0, or force (as in force setting) is enabled, set it to the value
+		static const cellContents_type decode[8] = {		//Indexed by ship | hit << 1 | miss << 2
+			ocean, ship, ocean, destroyed_ship,
+			shot_miss, ship, shot_miss, destroyed_ship
+		};
+
+		const int index = findTile(x >> 6, y >> 4);		//y >> 4 == y / tileRows
+		if(index < 0) return ocean;
+
+		const uint64_t (& tile)[planeCount][tileRows] = tiles[index].words;
+		const int shift = x & (bitsPerWord - 1);
+		const int row = y & (tileRows - 1);
+
+		const int code = int((tile[shipPlane][row] >> shift) & 1)
+			| int(((tile[hitPlane][row] >> shift) & 1) << 1)
+			| int(((tile[missPlane][row] >> shift) & 1) << 2);
+		return decode[code];
 	}
 
-	//This is the equivalent to FleetSunk() as mentioned in the homework.  I've called it something else to wrap the shot-checking in and to make what it does clearer.
-	void checkWinLoss()			//Checks the game data for win/loss conditions
+	void setSparseCell(int x, int y, cellContents_type cell)
 	{
-		{	//If there are no ships left on the board, the player wins
-			bool shipFound = false;
-
-			for(int x = 0; x < size.x; x++)
-			{
-				for(int y = 0; y < size.y; y++)
-				{
-					if(getContents(coordi(x, y)) == ship)
-					{
-						shipFound = true;
-						break;
-					}
-				}
-				if(shipFound) break;
-			}
+		const uint64_t isShip = (cell == ship || cell == destroyed_ship);
+		const uint64_t isHit = (cell == destroyed_ship);
+		const uint64_t isMiss = (cell == shot_miss);
+		if(!(isShip | isMiss) && findTile(x >> 6, y >> 4) < 0) return;		//Ocean on a tile that's all ocean already
+
+		uint64_t (& tile)[planeCount][tileRows] = useTile(x >> 6, y >> 4).words;
+		const int shift = x & (bitsPerWord - 1);
+		const uint64_t bit = uint64_t(1) << shift;
+		const int row = y & (tileRows - 1);
+
+		tile[shipPlane][row] = (tile[shipPlane][row] & ~bit) | (isShip << shift);
+		tile[hitPlane][row] = (tile[hitPlane][row] & ~bit) | (isHit << shift);
+		tile[missPlane][row] = (tile[missPlane][row] & ~bit) | (isMiss << shift);
+	}
 
-			if(shipFound == false) gameState = win;
-		}
+public:
+	void resize(coordi _size)	//Sets the dimensions of the board.  Clears the board to ocean
+	{
+		size = _size;
+		rowWords = (size.x + bitsPerWord - 1) / bitsPerWord;
+		sparse = (int64_t(planeCount) * size.y * rowWords > maxDenseWords);
 
-		if(shots <= 0)	//If the player is out of shots (Loss condition)
+		//Only one of the layouts is used, so the other's memory is given back
+		if(sparse) vector<uint64_t>().swap(words);
+		else
 		{
-			gameState = lose;
-			return;
+			vector<tile_type>().swap(tiles);
+			std::unordered_map<uint64_t, int>().swap(tileIndex);
+			words.assign(size_t(planeCount) * size.y * rowWords, 0);
 		}
-
-
+		clear();
 	}
 
-	shotResult fire(coordi at)	//Attempts to fire at 'at', and returns the restult as a shotResult type
+	void clear()	//Sets every cell to ocean.  A sparse board keeps the space its tiles used, so refilling it doesn't allocate
 	{
-		if(shots <= 0)		//If we have no shots remaining, we cannot fire.
+		if(sparse)
 		{
-			gameState = lose;
-			return noAmmo;
+			tiles.clear();
+			tileIndex.clear();
 		}
+		else std::fill(words.begin(), words.end(), 0);
+	}
 
-		shots--;
-
-		cellContents_type cell = getContents(at);
+	coordi getSize() const { return size; }
+	int getRowWords() const { return rowWords; }
+	bool isSparse() const { return sparse; }
 
-		switch(cell)
-		{
-			case ship:
-				setContents(at, destroyed_ship);
-				return hit;
+	uint64_t * data() { return words.empty() ? nullptr : &words[0]; }		//All of the planes of a dense board, for saving/loading them in one go
+	size_t wordCount() const { return words.size(); }
+	const vector<tile_type> & getTiles() const { return tiles; }			//The tiles of a sparse board that have been written to, for saving them
 
-			case destroyed_ship:
-				return alreadyFired;
+	size_t getMemoryUsed() const		//Roughly how many bytes the board is using.  Each hash map entry is counted as its key, its value and two pointers
+	{
+		return words.capacity() * sizeof(uint64_t) + tiles.capacity() * sizeof(tile_type)
+			+ tileIndex.size() * (sizeof(uint64_t) + sizeof(int) + 2 * sizeof(void *)) + tileIndex.bucket_count() * sizeof(void *);
+	}
 
-			case shot_miss:
-				return alreadyFired;
+	uint64_t getWord(plane_type plane, int w, int y) const		//Returns word 'w' of row 'y' of 'plane' (cells 64 * w to 64 * w + 63).  Does NOT check that it's on the board
+	{
+		if(!sparse) return words[(plane * size.y + y) * rowWords + w];
 
-			case ocean:
-				setContents(at, shot_miss);
-				return miss;
+		const int index = findTile(w, y >> 4);
+		return (index < 0 ? 0 : tiles[index].words[plane][y & (tileRows - 1)]);
+	}
 
-			default:
-				setContents(at, shot_miss);
-				return miss;
-				//If we don't have a case for the cell, assume it's data is bad and set it as a missed shot
-		}
+	void setWord(plane_type plane, int w, int y, uint64_t value)		//Sets word 'w' of row 'y' of 'plane'.  Does NOT check that it's on the board
+	{
+		if(!sparse) words[(plane * size.y + y) * rowWords + w] = value;
+		else if(value != 0 || findTile(w, y >> 4) >= 0) useTile(w, y >> 4).words[plane][y & (tileRows - 1)] = value;		//Ocean doesn't add a tile
 	}
 
-	shotResult fire(char _let, int _num)		//Attempts to convert the letter and number to coordinates, and returns the restult as a shotResult type
+	uint64_t getBits(plane_type plane, int x, int y) const		//Returns the 64 cells of row 'y' of 'plane' starting at 'x' (which doesn't have to be the start of a word), cell x in bit 0.  Cells past the end of the row are 0
 	{
-		return fire(coordi(toupper(_let) - 'A', _num));		//the letter coordinate is determined by toupper(_let) - 'A' because that means when _let == 'A', the result will be 0
+		const int w = x >> 6;
+		const int shift = x & (bitsPerWord - 1);
+		uint64_t bits = getWord(plane, w, y) >> shift;
+		if(shift > 0 && w + 1 < rowWords) bits |= getWord(plane, w + 1, y) << (bitsPerWord - shift);
+		return bits;
 	}
 
-	void loadFromFile(ifstream & file)		//Loads the game board from 'file'
+	//Calls visit(w, y, word) for every word of 'plane' in rows 'firstY' to 'lastY' - 1 that has something in it, row by row, left to right within a row.
+	//On a sparse board only the tiles that have been written to are looked at, so it takes time in proportion to the ships and shots, not to the size of the board
+	template <typename visitor_type> void forEachWord(plane_type plane, int firstY, int lastY, visitor_type visit) const
 	{
-		if(!file)
+		if(!sparse)
 		{
-			//File does not exist
-			throw file_notFound;
+			for(int y = firstY; y < lastY; y++)
+			{
+				const uint64_t * row = &words[(plane * size.y + y) * rowWords];
+				for(int w = 0; w < rowWords; w++)
+				{
+					if(row[w] != 0) visit(w, y, row[w]);
+				}
+			}
+			return;
 		}
 
-		//Load each line from the file, and store it in each row
-		for(int y = 0; y < size.y; y++)
+		//The tiles are stored in the order they were written, so the ones covering the rows are put in row-major order first
+		vector<int> order;
+		for(int i = 0; i < int(tiles.size()); i++)
 		{
-			string line;
-			getline(file, line);
-
-			if(!file.eof() || y == (size.y - 1))	//If the file ends before we're finished reading data (we expect file.eof() to be true for the last line, hence the y != size.y - 1)
-			{	//If the line from the file was loaded successfully
-				vector<cellContents_type> row = utilities::extractCellsFromString(line);
+			const int top = tiles[i].position.y * tileRows;
+			if(top + tileRows > firstY && top < lastY) order.push_back(i);
+		}
+		std::sort(order.begin(), order.end(), [&](int a, int b)
+		{
+			return tiles[a].position.y != tiles[b].position.y ? tiles[a].position.y < tiles[b].position.y : tiles[a].position.x < tiles[b].position.x;
+		});
 
-				if(row.size() > size.x)	//If the data from the file is larger than expected
-				{
-					fileErrors.push_back(file_lineTooLong);
-				}
-				else if(row.size() < size.x)	//If the data from the file is shorter than expected
-				{
-					fileErrors.push_back(file_lineTooShort);
-				}
+		for(size_t first = 0, last = 0; first < order.size(); first = last)
+		{
+			//Every tile in a row of tiles, then each row of cells across all of them
+			const int tileY = tiles[order[first]].position.y;
+			while(last < order.size() && tiles[order[last]].position.y == tileY) last++;
 
-				//Store the data loaded
-				for(int x = 0; x < size.x; x++)
-				{
-					if(x < row.size()) board[x][y] = row[x];
-					else
-					{
-						fileErrors.push_back(file_lineTooShort);
-						board[x][y] = ocean;
-					}
-				}
-			}
-			else
+			const int top = tileY * tileRows;
+			for(int y = std::max(top, firstY); y < std::min(top + tileRows, lastY); y++)
 			{
-				//If the line wasn't loaded properly, set a error flag and fill the empty space with ocean tiles
-				fileErrors.push_back(file_eof);
-				for(int x = 0; x < size.x; x++)
+				for(size_t i = first; i < last; i++)
 				{
-					board[x][y] = ocean;
+					const tile_type & tile = tiles[order[i]];
+					if(tile.words[plane][y - top] != 0) visit(tile.position.x, y, tile.words[plane][y - top]);
 				}
 			}
 		}
-
-		printErrors();
 	}
 
-	void loadFromFile(string filename)		//Loads the game board from a file, 'filename' 
+	bool getBit(plane_type plane, int x, int y) const { return (getWord(plane, x >> 6, y) >> (x & (bitsPerWord - 1))) & 1; }
+
+	cellContents_type getCell(int x, int y) const		//Returns the contents of the cell at (x, y).  Does NOT check that (x, y) is on the board, callers are expected to have already done that
 	{
-		ifstream file;
-		file.open(filename);
-		loadFromFile(file);
-		file.close();
+		static const cellContents_type decode[8] = {		//Indexed by ship | hit << 1 | miss << 2
+			ocean, ship, ocean, destroyed_ship,
+			shot_miss, ship, shot_miss, destroyed_ship
+		};
+
+		if(sparse) return getSparseCell(x, y);
+
+		const int shift = x & (bitsPerWord - 1);
+		const int index = wordIndex(shipPlane, x, y);
+		const int planeStride = size.y * rowWords;
+
+		const int code = int((words[index] >> shift) & 1)
+			| int(((words[index + planeStride] >> shift) & 1) << 1)
+			| int(((words[index + 2 * planeStride] >> shift) & 1) << 2);
+		return decode[code];
+	}
+
+	void setCell(int x, int y, cellContents_type cell)	//Sets the contents of the cell at (x, y).  Does NOT check that (x, y) is on the board
+	{	//There is no encoding for 'null' or 'invalid_cell', they are stored as ocean (which is how everything that reads the board treated them anyway)
+		if(sparse)
+		{
+			setSparseCell(x, y, cell);
+			return;
+		}
+
+		const int shift = x & (bitsPerWord - 1);
+		const uint64_t bit = uint64_t(1) << shift;
+		const int index = wordIndex(shipPlane, x, y);
+		const int planeStride = size.y * rowWords;
+
+		const uint64_t isShip = (cell == ship || cell == destroyed_ship);
+		const uint64_t isHit = (cell == destroyed_ship);
+		const uint64_t isMiss = (cell == shot_miss);
+
+		words[index] = (words[index] & ~bit) | (isShip << shift);
+		words[index + planeStride] = (words[index + planeStride] & ~bit) | (isHit << shift);
+		words[index + 2 * planeStride] = (words[index + 2 * planeStride] & ~bit) | (isMiss << shift);
 	}
 
-	void printErrors()		//Prints any errors encoutered when loading the file
+	int countLiveShipCells() const		//Returns the number of cells that contain a ship that has not been hit
 	{
-		if(fileErrors.size() > 0)
+		int count = 0;
+		for(auto iter = tiles.begin(); iter != tiles.end(); iter++)
 		{
-			cout << "The following errors were encountered when loading the file, but were recovered from:" << endl;
-			for(auto iter = fileErrors.begin(); iter != fileErrors.end(); iter++)
+			for(int row = 0; row < tileRows; row++)
 			{
-				cout << utilities::errorStateToString(*iter) << endl;
+				count += util::popcount(iter->words[shipPlane][row] & ~iter->words[hitPlane][row]);
 			}
+		}
+		if(sparse) return count;
 
-			cout << endl << "Press enter to continue" << endl;
-			string inp;
-			getline(cin, inp);
+		const uint64_t * ships = &words[0];
+		const uint64_t * hits = ships + size.y * rowWords;
+
+		for(int i = 0; i < size.y * rowWords; i++)
+		{
+			count += util::popcount(ships[i] & ~hits[i]);
 		}
+		return count;
 	}
 
-	void print(bool showHiddenShips = false)	//Prints the game board to the screen buffer, as well as the shots remaining
-	{
-		coordi displacement = coordi(3, 2);		//The coordinates of the upper left portion of the board on the buffer
+	void renderRow(int y, int firstX, int count, bool showHiddenShips, char * out) const	//Writes the glyph of each of the 'count' cells of row 'y' from 'firstX' on to 'out', each followed by a space (2 * count chars)
+	{	//Gives the same glyphs as utilities::toChar(getCell(x, y), showHiddenShips).  64 cells at a time are turned into masks of the cells showing 'H', 'M' and '#' (everything
+		//else is '~'), then 16 cells at a time are expanded to bytes through utilities::byteMasks() and blended with SSE2
+		static const char glyphs[8] = { '~', 'H', 'M', '~', '#', '~', '~', '~' };		//Indexed by hit | miss << 1 | shown ship << 2, at most one of which is set
 
-		for(int y = 0; y < size.y; y++)
+		for(int first = 0; first < count; first += bitsPerWord)
 		{
-			for(int x = 0; x < size.x; x++)
+			const uint64_t ships = getBits(shipPlane, firstX + first, y);
+			const uint64_t hits = getBits(hitPlane, firstX + first, y);
+			const uint64_t misses = getBits(missPlane, firstX + first, y);
+
+			const uint64_t hitMask = ships & hits;
+			const uint64_t missMask = misses & ~ships;
+			const uint64_t shipMask = (showHiddenShips ? ships & ~hits : 0);
+			const int cells = std::min(bitsPerWord, count - first);
+			char * to = out + 2 * first;
+
+			int x = 0;
+		#ifdef USE_SSE2
+			const uint64_t * expand = util::byteMasks();
+			const __m128i spaces = _mm_set1_epi8(' ');
+			for(; x + 16 <= cells; x += 16)
+			{
+				auto bytes = [&](uint64_t mask) { return _mm_set_epi64x((long long) expand[(mask >> (x + 8)) & 0xFF], (long long) expand[(mask >> x) & 0xFF]); };
+				const __m128i hit = bytes(hitMask);
+				const __m128i miss = bytes(missMask);
+				const __m128i ship = bytes(shipMask);
+				const __m128i any = _mm_or_si128(_mm_or_si128(hit, miss), ship);
+
+				__m128i glyph = _mm_andnot_si128(any, _mm_set1_epi8('~'));
+				glyph = _mm_or_si128(glyph, _mm_and_si128(hit, _mm_set1_epi8('H')));
+				glyph = _mm_or_si128(glyph, _mm_and_si128(miss, _mm_set1_epi8('M')));
+				glyph = _mm_or_si128(glyph, _mm_and_si128(ship, _mm_set1_epi8('#')));
+
+				_mm_storeu_si128((__m128i *) (to + 2 * x), _mm_unpacklo_epi8(glyph, spaces));
+				_mm_storeu_si128((__m128i *) (to + 2 * x + 16), _mm_unpackhi_epi8(glyph, spaces));
+			}
+		#endif
+			for(; x < cells; x++)
 			{
-				screen.write(coordi(x * 2, y) + displacement, utilities::toChar(getContents(coordi(x, y)), showHiddenShips));
+				to[2 * x] = glyphs[((hitMask >> x) & 1) | (((missMask >> x) & 1) << 1) | (((shipMask >> x) & 1) << 2)];
+				to[2 * x + 1] = ' ';
 			}
 		}
-
-		//Prints the shots remaining
-		screen.write(coordi(54 + 2, 2 + 15), "     ", true);
-		screen.write(coordi(54 + 2, 2 + 15), utilities::toString(getShots()));
 	}
 
-	void generateGameBoard()		//Randomly generates a game board to play on
+	void destroyAllShips()		//Marks every ship cell on the board as hit
 	{
-		cout << "Please be patient, this may take a second..." << endl;
-		emptyBoard();
-		
-		vector<int> lengths {2, 2, 3, 3, 4};
+		for(auto iter = tiles.begin(); iter != tiles.end(); iter++)
+		{
+			for(int row = 0; row < tileRows; row++)
+			{
+				iter->words[hitPlane][row] |= iter->words[shipPlane][row];
+			}
+		}
+		if(sparse) return;
+
+		uint64_t * ships = &words[0];
+		uint64_t * hits = ships + size.y * rowWords;
 
-		for(int iter = 0; iter < lengths.size(); iter++)		//Generate ships with lengths dictated in 'lengths'
+		for(int i = 0; i < size.y * rowWords; i++)
 		{
-			try { createShip(lengths[iter]); }
-			catch(...) { iter--; } //If createShip throws a shipexists exception, deincriment the iterator run it again to get new coordinates.  If it's anything else, just de-incriment the iterator and start over and run the randomizer again.  The issue is unlikely to crop up repeatedly.
+			hits[i] |= ships[i];
 		}
 	}
-
 };
 
-gameBoard_type gameBoard(coordi(25, 25));
-
-void promptUserToResizeWindow()		//Prompts the user to resize their window so that it is the correct height for the game
-{
-	cout << "You should be able to see this message along with the bottom one." << endl;
+namespace zobrist		//Zobrist hashing of game boards: every bit that can be set in a board's planes has its own random key, and a board's hash is the XOR of the keys of its set bits (and a key for its size)
+{	//Boards can have 10^12 cells, so the keys aren't kept in a table.  Each is made when it's needed by mixing the bit's position, so the same bit always gets the same key.
+	//Changing a cell XORs in the keys of the bits that changed, so a board's hash is kept up to date in O(1) as it is played on.  The 'check' keys are made the same way from a
+	//different seed, and give a second hash that is independent of the first, which transpositionCache_type uses to spot two positions that share a hash
+	const uint64_t hashSeed = 0x5A0B1E57C0FFEE01ULL;
+	const uint64_t checkSeed = 0x3C6EF372FE94F82BULL;
 
-	for(int i = 1; i < 28; i++)
+	inline uint64_t key(int plane, int x, int y, uint64_t seed)		//The key for bit (x, y) of 'plane'.  Boards are at most 2^20 cells across, so x and y fit in 21 bits; plane bitBoard_type::planeCount is used for the board's size
 	{
-		cout << endl;
+		uint64_t state = ((((uint64_t(uint32_t(y)) << 21) | uint32_t(x)) << 2) | uint32_t(plane)) ^ seed;
+		return util::splitMix64(state);		//A bijection, so no two bits share a key
 	}
-	cout << "Please resize your window so that you can see this message and the" << endl << "message at the top at the same time." << endl;
-	cout << "Please press enter when you're done.";
-	{	//Waits until the user presses enter to continue.  I would use cin.ignore(numeric_limits<streamsize>::max(), '\n'), but numeric_limits is missing for some reason
-		string inp;
-		getline(cin, inp);
+
+	inline int planeBits(cellContents_type cell)		//Which planes a cell's contents set, as bitBoard_type::setCell() stores them: ship in bit 0, hit in bit 1, miss in bit 2
+	{
+		static const int bits[] = { 0, 0, 1, 3, 4, 0 };		//Indexed by cellContents_type
+		return bits[cell];
 	}
-	clearConsole();
 }
 
-void setup()		//General startup actions
+//A fixed size table of values found for positions, keyed by their Zobrist hash, that any number of threads can read and write at once without locks.  Each hash has one slot (the low
+//bits of the hash), and a store always replaces what was there.  A slot is guarded by a sequence number that is odd while it is being written: a reader that sees it change copies
+//nothing, and a writer that finds the slot being written skips the store, so nobody ever waits.  Every entry keeps a second, independent hash of its position as well, so a lookup
+//that finds the same hash for a different position is counted as a collision (and missed) rather than returned
+template <typename value_type> class transpositionCache_type
 {
-	srand(std::time(NULL));	//Seed the randomizer
+	static_assert(std::is_trivially_copyable<value_type>::value, "Cached values are copied a word at a time");
+	static const int valueWords = int((sizeof(value_type) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
 
-	promptUserToResizeWindow();
-	gameState = title;
+	struct slot_type
+	{
+		std::atomic<uint64_t> sequence;
+		std::atomic<uint64_t> hash;
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> words[valueWords];
+	};
+
+	std::unique_ptr<slot_type[]> slots;
+	size_t mask = 0;
+
+	//Statistics, counted with relaxed atomics.  Each counter is on its own cache line so threads counting different things don't slow each other down
+	struct alignas(64) counter_type { std::atomic<uint64_t> value; };
+	counter_type lookups, hits, collisions, stores, evictions, contended;
+
+public:
+	struct stats_type
+	{
+		uint64_t lookups = 0;
+		uint64_t hits = 0;
+		uint64_t collisions = 0;	//Lookups that found an entry with the same hash but a different check hash: a different position
+		uint64_t stores = 0;
+		uint64_t evictions = 0;		//Stores that replaced the entry for a different position
+		uint64_t contended = 0;		//Lookups and stores that gave up because another thread was writing the slot
 
-	screen.setSize(coordi(77, 30));
+		double hitRate() const { return lookups > 0 ? double(hits) / lookups : 0; }
+	};
 
-	//Draw border for game board
+	transpositionCache_type(size_t slotCount)		//Makes a cache with 'slotCount' slots, rounded down to a power of 2 (at least 1)
 	{
-		const int xMin = 2;
-		const int xMax = 52;
-		const int yMin = 1;
-		const int yMax = 27;
+		size_t count = 1;
+		while(count * 2 <= slotCount) count *= 2;
+		slots.reset(new slot_type[count]);
+		mask = count - 1;
+		clear();
+	}
 
-		//Top and bottom border
-		for(int x = xMin; x < xMax; x++)
+	void clear()		//Empties the cache and zeroes the statistics.  Not safe while other threads are using the cache
+	{
+		for(size_t i = 0; i <= mask; i++)
 		{
-			screen.write(coordi(x, yMin), char(205));
-			screen.write(coordi(x, yMax), char(205));
+			slots[i].sequence.store(0, std::memory_order_relaxed);
+			slots[i].hash.store(0, std::memory_order_relaxed);
+			slots[i].check.store(0, std::memory_order_relaxed);
+			for(int w = 0; w < valueWords; w++) slots[i].words[w].store(0, std::memory_order_relaxed);
 		}
+		for(counter_type * counter : { &lookups, &hits, &collisions, &stores, &evictions, &contended }) counter->value.store(0, std::memory_order_relaxed);
+	}
+
+	size_t getSlotCount() const { return mask + 1; }
+
+	bool lookup(uint64_t hash, uint64_t check, value_type & value)		//Copies the value stored for the position with 'hash' and 'check' into 'value'.  Returns false (and leaves 'value' alone) if there isn't one
+	{
+		lookups.value.fetch_add(1, std::memory_order_relaxed);
+		slot_type & slot = slots[hash & mask];
 
-		//The left and right border
-		for(int y = yMin; y < yMax; y++)
+		const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+		const uint64_t storedHash = slot.hash.load(std::memory_order_relaxed);
+		const uint64_t storedCheck = slot.check.load(std::memory_order_relaxed);
+		uint64_t words[valueWords];
+		for(int w = 0; w < valueWords; w++) words[w] = slot.words[w].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if((before & 1) != 0 || slot.sequence.load(std::memory_order_relaxed) != before)		//Written while it was being read
 		{
-			screen.write(coordi(xMin, y), char(186));
-			screen.write(coordi(xMax, y), char(186));
+			contended.value.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		if(before == 0 || storedHash != hash) return false;		//Empty, or holding another position
+		if(storedCheck != check)
+		{
+			collisions.value.fetch_add(1, std::memory_order_relaxed);
+			return false;
 		}
 
-		//The corners
-		screen.write(coordi(xMin, yMin), char(201));	//Top left
-		screen.write(coordi(xMax, yMin), char(187));	//Top right
-		screen.write(coordi(xMin, yMax), char(200));	//Bottom left
-		screen.write(coordi(xMax, yMax), char(188));	//Bottom right
-
-		//game board title 
-		screen.write(coordi(xMin + 19, yMin), char(185));	//The left and right borders for the title
-		screen.write(coordi(xMin + 30, yMin), char(204));
-		screen.write(coordi(xMin + 20, yMin), "Game Board");
+		std::memcpy(&value, words, sizeof(value_type));
+		hits.value.fetch_add(1, std::memory_order_relaxed);
+		return true;
 	}
 
-	//Write the coordinate indexes along the edge of the board
+	void store(uint64_t hash, uint64_t check, const value_type & value)		//Stores 'value' for the position with 'hash' and 'check', replacing whatever was in its slot
 	{
-		//Letters along the top
-		for(int x = 0; x < 25; x++)
+		slot_type & slot = slots[hash & mask];
+
+		uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		if((sequence & 1) != 0 || !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed))
 		{
-			screen.write(coordi(x * 2 + 3, 0), char(65 + x));
+			contended.value.fetch_add(1, std::memory_order_relaxed);
+			return;
 		}
+		std::atomic_thread_fence(std::memory_order_release);
 
-		//Numbers down the side 
-		for(int y = 0; y < 25; y++)
+		if(sequence != 0 && (slot.hash.load(std::memory_order_relaxed) != hash || slot.check.load(std::memory_order_relaxed) != check))
 		{
-			screen.write(coordi(0, y + 2), utilities::toString(y));
+			evictions.value.fetch_add(1, std::memory_order_relaxed);
 		}
+
+		uint64_t words[valueWords] = {};
+		std::memcpy(words, &value, sizeof(value_type));
+		slot.hash.store(hash, std::memory_order_relaxed);
+		slot.check.store(check, std::memory_order_relaxed);
+		for(int w = 0; w < valueWords; w++) slot.words[w].store(words[w], std::memory_order_relaxed);
+
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+		stores.value.fetch_add(1, std::memory_order_relaxed);
 	}
 
-	//Draw the instructions to the right side of the screen
+	stats_type getStats() const
 	{
-		const int menuX = 54;
-		const int menuY = 2;
-
-		screen.write(coordi(menuX, menuY), "Key:");
-		screen.write(coordi(menuX, menuY + 1), "~ = ocean tile");
-		screen.write(coordi(menuX, menuY + 2), "H = hit");
-		screen.write(coordi(menuX, menuY + 3), "M = miss");
+		stats_type stats;
+		stats.lookups = lookups.value.load(std::memory_order_relaxed);
+		stats.hits = hits.value.load(std::memory_order_relaxed);
+		stats.collisions = collisions.value.load(std::memory_order_relaxed);
+		stats.stores = stores.value.load(std::memory_order_relaxed);
+		stats.evictions = evictions.value.load(std::memory_order_relaxed);
+		stats.contended = contended.value.load(std::memory_order_relaxed);
+		return stats;
+	}
+};
 
-		screen.write(coordi(menuX, menuY + /*5*/7), "Commands:");
-		//screen.write(coordi(menuX, menuY + 6), "help");
-		//screen.write(coordi(menuX, menuY + 7), "   shows help");
+namespace binaryLevel		//The binary level format: a header, the ship records, then the three bit planes of the board.  All numbers are little-endian
+{	//Header (32 bytes): "BSLV", version (16 bit), header size (16 bit), width, height, shots remaining, maximum shots, ship count, words per row (32 bit each)
+	//Each ship (20 bytes): start x, start y, direction, length, hits (32 bit each)
+	//Planes (version 1): ship, hit, miss, each height * words per row 64-bit words, row by row, with cell x of a row in bit x % 64 of word x / 64
+	//Planes (version 2, written for sparse boards): a tile count (32 bit), then for each tile its column and row (32 bit each) and its ship, hit and miss words (see bitBoard_type::tile_type)
+	const char magic[4] = { 'B', 'S', 'L', 'V' };
+	const uint16_t version = 1;
+	const uint16_t tiledVersion = 2;
+	const uint32_t tileSize = 8 + bitBoard_type::planeCount * bitBoard_type::tileRows * 8;
+	const uint32_t headerSize = 32;
+	const uint32_t shipSize = 20;
+
+	bool isLittleEndian()
+	{
+		const uint16_t test = 1;
+		return *(const uint8_t *) &test == 1;
+	}
 
-		screen.write(coordi(menuX, menuY + 9), "fire <letter><number>");
-		screen.write(coordi(menuX, menuY + 10), "   fires at the");
-		screen.write(coordi(menuX, menuY + 11), "   specified location");
-		screen.write(coordi(menuX, menuY + 12), "   ex: fire A5");
+	void put16(string & out, uint16_t value) { for(int i = 0; i < 2; i++) out += char((value >> (8 * i)) & 0xFF); }
+	void put32(string & out, uint32_t value) { for(int i = 0; i < 4; i++) out += char((value >> (8 * i)) & 0xFF); }
+	void put64(string & out, uint64_t value) { for(int i = 0; i < 8; i++) out += char((value >> (8 * i)) & 0xFF); }
+	void store64(char * out, uint64_t value)		//Writes 'value' to 'out', which already has room for it
+	{
+		if(isLittleEndian()) std::memcpy(out, &value, sizeof(value));
+		else for(int i = 0; i < 8; i++) out[i] = char((value >> (8 * i)) & 0xFF);
+	}
 
-		screen.write(coordi(menuX, menuY + 14), "Shots remaining:");
+	uint16_t get16(const char * in) { return uint16_t(uint8_t(in[0]) | (uint8_t(in[1]) << 8)); }
+	uint32_t get32(const char * in) { return uint32_t(get16(in)) | (uint32_t(get16(in + 2)) << 16); }
+	uint64_t get64(const char * in) { return uint64_t(get32(in)) | (uint64_t(get32(in + 4)) << 32); }
 
-	}
-}
+	bool isBinaryLevel(const char * data, size_t length) { return length >= 4 && std::memcmp(data, magic, 4) == 0; }
+};
 
-void printPlayerFeedback(string feedback)		//Prints 'feedback' for the player to the specific spot in the screen buffer reserved for it 
+class mappedFile_type		//A file mapped into memory (read only), so it can be read without copying it into a buffer first.  Unmapped when destroyed
 {
-	screen.clearRow(28);
-	screen.write(coordi(0, 28), feedback, true);
-}
+	const char * contents = nullptr;
+	size_t length = 0;
+	bool opened = false;
 
-bool handleDebugCommands(vector<string> command)		//Checks for and executes debug commands in 'command' if they exist.  Returns 'true' if it is a debug command, false if not
-{
-	if(command.size() == 0) return false;	//If the argument isn't a command, it can't be a debug command
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#endif
 
-	if(command[0].size() > 0 && command[0][0] == '#' && allowDebugCommands == true)		//Debug command handler (requires that allowDebugCommands be true to enable them)
+public:
+	mappedFile_type(string filename)
 	{
-		command[0] = command[0].substr(1);	//Trims the '#' from the beginning of the first term to make things more readable
-
-		if(debugCommandsOn == false)				//If debug commands are enabled
+	#ifdef _WIN32
+		file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(file == INVALID_HANDLE_VALUE) return;
+		opened = true;
+
+		LARGE_INTEGER fileSize;
+		if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;	//An empty file can't be mapped, but it's still a (very short) file
+		length = size_t(fileSize.QuadPart);
+
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(mapping != NULL) contents = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	#else
+		int descriptor = open(filename.c_str(), O_RDONLY);
+		if(descriptor < 0) return;
+		opened = true;
+
+		struct stat status;
+		if(fstat(descriptor, &status) == 0 && status.st_size > 0)	//An empty file can't be mapped, but it's still a (very short) file
 		{
-			if(command[0] == "enable")				//Enables debug commands
+			void * mapped = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if(mapped != MAP_FAILED)
 			{
-				debugCommandsOn = true;
-				printPlayerFeedback("Debug commands enabled.  #disable to turn them off.");
-				return true;
+				contents = (const char *) mapped;
+				length = size_t(status.st_size);
+				madvise(mapped, length, MADV_SEQUENTIAL);
 			}
 		}
-		else
-		{
-			if(command[0] == "enable")				//Debug commands are already on, so we just say so. 
-			{
-				printPlayerFeedback("Debug commands are already enabled.");
-				return true;
-			}
-			else if(command[0] == "disable")		//Disables debug commands
-			{
-				debugCommandsOn = false;
-				printPlayerFeedback("Debug commands are now disabled.");
-				return true;
-			}
-			else if(command[0] == "setshots")		//Sets the number of shots the player has remaining
-			{
-				if(command.size() >= 2)
-				{
-					try
-					{
-						gameBoard.setShots(utilities::toNum(command[1]));
-					}
-					catch(errorstates err)
-					{
-						if(err == convert_fail_strInt)
-						{
-							printPlayerFeedback("\"" + command[1] + "\" could not be converted to an integer.");
-						}
-						else throw err;
-					}
+		close(descriptor);		//The mapping stays valid after the file is closed
+	#endif
 
-				}
-			}
-			else if(command[0] == "forcerun")	//Forces the game to run, preventing it from closing
-			{
-				debug_forceRun = true;
-			}
-			else if(command[0] == "normalrun")	//Disables forceRun, returns the game to it's normal state
-			{
-				debug_forceRun = false;
-			}
-			else if(command[0] == "showships")
-			{
-				debug_showShips = true;
-			}
-			else if(command[0] == "hideships")
-			{
-				debug_showShips = false;
-			}
-			else if(command[0] == "killall")
-			{
-				for(int x = 0; x < gameBoard.getBoardSize().x; x++)
-				{
-					for(int y = 0; y < gameBoard.getBoardSize().y; y++)
-					{
-						if(gameBoard.getContents(coordi(x, y)) == ship)
-						{
-							gameBoard.setContents(coordi(x, y), destroyed_ship);
-						}
-					}
-				}
-			}
-		}
+		if(contents == nullptr) length = 0;
 	}
-	else return false;
-
-	return true;
-}
-
-void lossScreen()		//Prints the loss screen when the player loses
-{
-	gameBoard.print(true);
 
-	screen.clearRow(28);
-	screen.clearRow(29);
+	~mappedFile_type()
+	{
+	#ifdef _WIN32
+		if(contents != nullptr) UnmapViewOfFile(contents);
+		if(mapping != NULL) CloseHandle(mapping);
+		if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	#else
+		if(contents != nullptr) munmap((void *) contents, length);
+	#endif
+	}
 
-	printPlayerFeedback("We've lost, Admiral.");
-	screen.write(coordi(0, 29), "Press enter to return to the title screen.");
-	screen.pushToConsole();
+	mappedFile_type(const mappedFile_type &) = delete;
+	mappedFile_type & operator=(const mappedFile_type &) = delete;
 
+	bool isOpen() { return opened; }
+	const char * data() { return contents; }
+	size_t size() { return length; }
+};
 
-	getline(cin, string());	//Wait for the user to press enter (getline and store it in a new string that will immediatley be deconstructed)
+struct shipRecord_type		//One ship on the game board, used to track how damaged each ship is without scanning the board
+{
+	coordi start;				//The first cell of the ship
+	direction_type direction;	//The direction the ship extends in from 'start'
+	int length;
+	int hits;					//The number of the ship's cells that have been hit
 
-	gameState = title;
+	bool isSunk() const { return hits >= length; }
 
+	bool covers(coordi pos) const		//Returns true when 'pos' is one of the ship's cells
+	{
+		coordi step = util::toStep(direction);
+		int along = (step.x != 0 ? (pos.x - start.x) * step.x : (pos.y - start.y) * step.y);	//How far along the ship 'pos' is
+		coordi offset(pos.x - start.x - step.x * along, pos.y - start.y - step.y * along);		//How far off of the ship's line 'pos' is
 
-}
+		return offset.x == 0 && offset.y == 0 && 0 <= along && along < length;
+	}
+};
 
-void winScreen()	//Prints the victory screen when the player wins
+struct shipProblem_type		//Something wrong with how the ships on a loaded board are laid out, found by shipLabeler_type
 {
-	gameBoard.print(true);
-
-	screen.clearRow(28);
-	screen.clearRow(29);
+	errorstates error;		//file_shipsTouching or file_shipBent
+	coordi at;				//Where: the top left cell of the group of ship cells with the problem, or the cell where two ships touch corners
+};
 
-	printPlayerFeedback("We've won, Admiral!");
-	screen.write(coordi(0, 29), "Press enter to return to the title screen.");
-	screen.pushToConsole();
+class shipLabeler_type		//Works out where the ships are on a board that only has cells (a loaded level): every group of ship cells joined side-on is a ship
+{							//Each row is cut into runs of ship cells a word at a time, and runs that overlap a run in the row above are joined with union-find, so the time taken
+							//goes up with the number of runs, not the size of the board.  Big boards are cut into strips of rows, each labeled on its own thread, then the strips
+							//are joined where they meet.  Groups that aren't a straight line are reported and split into straight ships, so every ship cell belongs to one ship
+public:
+	static const int minParallelCells = 1 << 22;	//Boards with fewer cells than this are labeled on the calling thread, as starting the threads would take longer
 
+private:
+	struct run_type		//A run of ship cells in one row
+	{
+		int x0, x1;		//The first and last cells of the run
+		int y;
+		int hits;		//How many of the run's cells have been hit
+	};
 
-	getline(cin, string());	//Wait for the user to press enter (getline and store it in a new string that will immediatley be deconstructed)
+	struct corner_type		//Two runs in neighbouring rows that only touch at a corner
+	{
+		int upper, lower;	//The runs
+		coordi at;			//The cell of the upper run at the corner
+	};
 
-	gameState = title;
-}
+	struct strip_type		//The runs found in a strip of rows, and how they're joined.  Indices are into the strip's own runs until the strips are put together
+	{
+		vector<run_type> runs;
+		vector<int> parent;		//The union-find forest.  A group's root is always its first run, so a run's parent always comes before it
+		vector<corner_type> corners;
 
+		int firstRun = 0, lastRun = 0;		//Once the strips are put together, the runs that were in this strip
+		vector<shipRecord_type> ships;		//The ships whose top left cells are in this strip
+		vector<shipProblem_type> found;		//Which of them weren't straight, in row-major order
+	};
 
-void mainLoop()		//The main loop of the program, containing all of the game's main logic
-{
-	while(gameState != quitting)	//Loop unless we're quitting
+	static int findRoot(vector<int> & parent, int run)		//Returns the first run (in row-major order) of the group 'run' is in
 	{
-		if(gameState == title)
+		while(parent[run] != run)
 		{
-			clearConsole();
-
-			cout << "Please select an option:" << endl;
+			parent[run] = parent[parent[run]];		//Path halving
+			run = parent[run];
+		}
+		return run;
+	}
 
-			cout << "1) Load game board from file" << endl;
-			cout << "2) Generate new game board" << endl;
-			cout << "3) Quit" << endl;
+	static void join(vector<int> & parent, int a, int b)	//Puts the groups of runs 'a' and 'b' together, under whichever root comes first
+	{
+		a = findRoot(parent, a);
+		b = findRoot(parent, b);
+		if(a < b) parent[b] = a;
+		else if(b < a) parent[a] = b;
+	}
 
-			string input;
+	//Joins the runs from 'upper' to 'upperEnd' (one row) to the runs from 'lower' to 'lowerEnd' (the row below) that overlap them, and records the ones that only touch at a corner.
+	//Both rows are in order left to right, so they're walked together, always moving on from the run that ends first (it can't touch anything further along the other row)
+	static void joinRows(const vector<run_type> & runs, vector<int> & parent, vector<corner_type> & corners, int upper, int upperEnd, int lower, int lowerEnd)
+	{
+		while(upper < upperEnd && lower < lowerEnd)
+		{
+			const run_type & a = runs[upper];
+			const run_type & b = runs[lower];
+			if(a.x0 <= b.x1 && b.x0 <= a.x1) join(parent, upper, lower);
+			else if(a.x1 + 1 == b.x0) corners.push_back({upper, lower, coordi(a.x1, a.y)});
+			else if(b.x1 + 1 == a.x0) corners.push_back({upper, lower, coordi(a.x0, a.y)});
+
+			if(a.x1 <= b.x1) upper++;
+			else lower++;
+		}
+	}
 
-			//Loop until we get valid data from the player
-			while(true)
+	static void labelStrip(const bitBoard_type & board, int firstY, int lastY, strip_type & strip)	//Finds the runs in rows 'firstY' to 'lastY' - 1, and joins the ones in the strip that touch
+	{
+		vector<run_type> & runs = strip.runs;
+		board.forEachWord(bitBoard_type::shipPlane, firstY, lastY, [&](int w, int y, uint64_t word)
+		{
+			const int base = w * bitBoard_type::bitsPerWord;
+			const uint64_t hitWord = board.getWord(bitBoard_type::hitPlane, w, y);
+			while(word != 0)
 			{
-				getline(cin, input);
-
-				if(input.size() == 0 || !(1 <= utilities::toNum(input[0], true) && utilities::toNum(input[0], true) <= 3))
-				{
-					cout << "I'm sorry, I don't understand \"" << input << "\".  Please try again." << endl;
-				}
-				else break;
-			}
+				const int start = util::countTrailingZeros(word);
+				const uint64_t rest = ~(word >> start);		//Zero for each ship cell from 'start' on, up to the first cell without a ship
+				const int length = (rest == 0 ? bitBoard_type::bitsPerWord : util::countTrailingZeros(rest));
+				const uint64_t cells = (start + length == bitBoard_type::bitsPerWord ? word : word & ((uint64_t(1) << (start + length)) - 1));	//The cells of the run
+				const int hits = util::popcount(hitWord & cells);
 
-			if(input[0] == '1')
-			{
-				screen.clearRow(29);
-				screen.write(coordi(0, 29), "Please enter a command, Admiral.");
-				string filename = "";
-				while(true)
+				if(start == 0 && !runs.empty() && runs.back().y == y && runs.back().x1 == base - 1)		//Carries on a run from the last word
 				{
-					cout << endl << "Please enter a file to open:";
-
-					getline(cin, filename);
-					if(filename == "")
-					{
-						cout << "Please enter a filename." << endl;
-					}
-					else break;
+					runs.back().x1 += length;
+					runs.back().hits += hits;
 				}
-				//Load the game board from a file
+				else runs.push_back({base + start, base + start + length - 1, y, hits});
 
-				//Load level data
-				{
-					cout << "Attempting to load level data..." << endl;
-					try
-					{
-						gameBoard.emptyBoard();
-						gameBoard.loadFromFile(filename);// "levelData.dat");
-					}
-					catch(errorstates error)
-					{
-						if(error == file_notFound) cout << "An error was encoutered: The file could not be found." << endl;
-						else cout << "An unspecified error was encountered." << endl;
-						cout << "Generating new game board..." << endl;
-						gameBoard.generateGameBoard();
-					}
-					gameState = running;
-				}
-			}
-			else if(input[0] == '2')
-			{
-				screen.clearRow(29);
-				screen.write(coordi(0, 29), "Please enter a command, Admiral.");
-				//Generate a new game board
-				gameBoard.generateGameBoard();
-				gameState = running;
-			}
-			else if(input[0] == '3')
-			{
-				gameState = quitting;
+				word &= ~cells;
 			}
+		});
 
-			screen.clearRow(28);		//Clear the row used for feedback on the buffer, in case the game has already been run once
-
-		}
-		else
+		strip.parent.resize(runs.size());
+		for(int i = 0; i < int(runs.size()); i++)
 		{
-			//Check for win/loss conditions
-			gameBoard.checkWinLoss();
-
-			//Push the newest data to the screen
-			gameBoard.print(debug_showShips && debugCommandsOn);
+			strip.parent[i] = i;
+		}
 
-			if(gameState == quitting) printPlayerFeedback("gameState == quitting.  Enter #forceRun to prevent the game from closing.");
-			screen.pushToConsole();
-			
-			string input;
-			if(gameState == running || debugCommandsOn) getline(cin, input);	//get input from the user
+		//Join each row to the row above it
+		int upper = 0, upperEnd = 0;
+		for(int first = 0, last = 0; first < int(runs.size()); first = last)
+		{
+			while(last < int(runs.size()) && runs[last].y == runs[first].y) last++;
+			if(upper < upperEnd && runs[upper].y == runs[first].y - 1) joinRows(runs, strip.parent, strip.corners, upper, upperEnd, first, last);
+			upper = first;
+			upperEnd = last;
+		}
+	}
 
-			vector<string> command = utilities::separateStringsBySpaces(utilities::toLower(input));
+	struct group_type		//A group of joined runs, kept at the group's root
+	{
+		int minX, maxX;		//The leftmost and rightmost cells
+		int maxY;			//The bottom row (the top row is the root's)
+		int cells, hits;
+		int first;			//If the group isn't a straight line, its first run (the rest follow through 'next').  -1 if it is
+	};
 
-			screen.clearRow(28);		//Clear the row used for feedback
+	struct splitScratch_type	//Working space for splitGroup(), kept from group to group so splitting doesn't allocate
+	{
+		vector<coordi> cells;		//The cells of the group, in row-major order
+		vector<char> hit;			//Whether each of them has been hit
+		vector<char> used;
+		vector<int> rowOrder, columnOrder;
+		vector<shipRecord_type> split[2];
+	};
+
+	//Makes a ship of every line of at least 'minLength' unused cells running in 'direction' (east or south), going through the cells in 'order' (row-major for east,
+	//column-major for south) and marking the cells it uses as used
+	static void takeLines(splitScratch_type & scratch, const vector<int> & order, direction_type direction, int minLength, vector<shipRecord_type> & ships)
+	{
+		const vector<coordi> & cells = scratch.cells;
+		const coordi step = util::toStep(direction);
+		for(size_t first = 0, last = 0; first < order.size(); first = last)
+		{
+			last = first + 1;
+			if(scratch.used[order[first]]) continue;
+			while(last < order.size() && !scratch.used[order[last]] && cells[order[last]].x == cells[order[last - 1]].x + step.x && cells[order[last]].y == cells[order[last - 1]].y + step.y) last++;
+			if(int(last - first) < minLength) continue;
+
+			shipRecord_type ship;
+			ship.start = cells[order[first]];
+			ship.direction = direction;
+			ship.length = int(last - first);
+			ship.hits = 0;
+			for(size_t i = first; i < last; i++)
+			{
+				scratch.used[order[i]] = true;
+				ship.hits += scratch.hit[order[i]];
+			}
+			ships.push_back(ship);
+		}
+	}
+
+	//Splits a group of ship cells that isn't a straight line (in 'scratch') into straight ships, taking the horizontal lines first then what's left as vertical lines,
+	//or the other way around, whichever makes fewer ships.  Returns file_shipsTouching if the ships that makes all lie the same way (so they were ships lying side by
+	//side), file_shipBent if they don't
+	static errorstates splitGroup(splitScratch_type & scratch, vector<shipRecord_type> & ships)
+	{
+		const vector<coordi> & cells = scratch.cells;
+		const int count = int(cells.size());
+		scratch.rowOrder.resize(count);
+		scratch.columnOrder.resize(count);
+		for(int i = 0; i < count; i++)
+		{
+			scratch.rowOrder[i] = scratch.columnOrder[i] = i;
+		}
+		std::sort(scratch.columnOrder.begin(), scratch.columnOrder.end(), [&](int a, int b) { return cells[a].x != cells[b].x ? cells[a].x < cells[b].x : a < b; });
+
+		for(int pass = 0; pass < 2; pass++)		//Horizontal lines first, then vertical lines first
+		{
+			scratch.used.assign(count, false);
+			scratch.split[pass].clear();
+			takeLines(scratch, (pass == 0 ? scratch.rowOrder : scratch.columnOrder), (pass == 0 ? east : south), 2, scratch.split[pass]);
+			takeLines(scratch, (pass == 0 ? scratch.columnOrder : scratch.rowOrder), (pass == 0 ? south : east), 1, scratch.split[pass]);
+		}
+
+		const vector<shipRecord_type> & best = scratch.split[scratch.split[1].size() < scratch.split[0].size() ? 1 : 0];
+		bool across = false, down = false;
+		for(auto iter = best.begin(); iter != best.end(); iter++)
+		{
+			if(iter->length > 1 && iter->direction == east) across = true;
+			if(iter->length > 1 && iter->direction == south) down = true;
+		}
+
+		ships.insert(ships.end(), best.begin(), best.end());
+		return (across && down ? file_shipBent : file_shipsTouching);
+	}
+
+	//Makes the ships of the groups whose roots are in 'strip', splitting the ones that aren't straight (which are noted in 'found')
+	static void findShips(const bitBoard_type & board, const vector<run_type> & runs, const vector<int> & parent, const vector<group_type> & groups, const vector<int> & next, strip_type & strip)
+	{
+		splitScratch_type scratch;
+		for(int root = strip.firstRun; root < strip.lastRun; root++)
+		{
+			if(parent[root] != root) continue;
+
+			const group_type & group = groups[root];
+			if(group.first < 0)		//One row or one column: a straight ship
+			{
+				shipRecord_type ship;
+				ship.start = coordi(group.minX, runs[root].y);
+				ship.direction = (group.maxY == runs[root].y ? east : south);
+				ship.length = group.cells;
+				ship.hits = group.hits;
+				strip.ships.push_back(ship);
+				continue;
+			}
+
+			scratch.cells.clear();
+			scratch.hit.clear();
+			for(int i = group.first; i >= 0; i = next[i])
+			{
+				uint64_t hits = 0;
+				for(int x = runs[i].x0; x <= runs[i].x1; x++, hits >>= 1)
+				{
+					if((x - runs[i].x0) % bitBoard_type::bitsPerWord == 0) hits = board.getBits(bitBoard_type::hitPlane, x, runs[i].y);
+					scratch.cells.push_back(coordi(x, runs[i].y));
+					scratch.hit.push_back(char(hits & 1));
+				}
+			}
+			strip.found.push_back({splitGroup(scratch, strip.ships), scratch.cells[0]});
+		}
+	}
+
+	static bool comesBefore(const shipProblem_type & a, const shipProblem_type & b) { return a.at.y != b.at.y ? a.at.y < b.at.y : a.at.x < b.at.x; }	//Row-major order
+
+public:
+	//Finds the ships on 'board', adding them to 'ships' in row-major order of their top left cells, and adds anything wrong with how they're laid out to 'problems',
+	//in row-major order.  The result doesn't depend on 'threadCount', the number of threads to use for big boards (0 = one per core)
+	static void label(const bitBoard_type & board, vector<shipRecord_type> & ships, vector<shipProblem_type> & problems, int threadCount = 0)
+	{
+		const coordi size = board.getSize();
+		if(threadCount <= 0) threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+		if(int64_t(size.x) * size.y < minParallelCells) threadCount = 1;
+		threadCount = std::max(1, std::min(threadCount, size.y));
+
+		auto inParallel = [threadCount](auto work)		//Calls work(s) for every strip 's', each on its own thread (the calling thread takes the first strip)
+		{
+			vector<std::thread> threads;
+			for(int s = 1; s < threadCount; s++)
+			{
+				threads.push_back(std::thread(work, s));
+			}
+			work(0);
+
+			for(auto iter = threads.begin(); iter != threads.end(); iter++)
+			{
+				iter->join();
+			}
+		};
+
+		vector<strip_type> strips(threadCount);
+		const int perStrip = (size.y + threadCount - 1) / threadCount;
+		inParallel([&](int s) { labelStrip(board, std::min(size.y, s * perStrip), std::min(size.y, (s + 1) * perStrip), strips[s]); });
+
+		//Put the strips together, joining the last row of each to the first row of the next.  The corners stay in row-major order
+		vector<run_type> runs;
+		vector<int> parent;
+		vector<corner_type> corners;
+		runs.swap(strips[0].runs);		//The first strip is taken over as it is
+		parent.swap(strips[0].parent);
+		corners.swap(strips[0].corners);
+		strips[0].lastRun = int(runs.size());
+		for(int s = 1; s < threadCount; s++)
+		{
+			const int offset = int(runs.size());
+			runs.insert(runs.end(), strips[s].runs.begin(), strips[s].runs.end());
+			for(auto iter = strips[s].parent.begin(); iter != strips[s].parent.end(); iter++)
+			{
+				parent.push_back(*iter + offset);
+			}
+
+			if(offset > 0 && offset < int(runs.size()) && runs[offset - 1].y == runs[offset].y - 1)
+			{
+				int upper = offset - 1;
+				while(upper > 0 && runs[upper - 1].y == runs[offset - 1].y) upper--;
+				int lowerEnd = offset;
+				while(lowerEnd < int(runs.size()) && runs[lowerEnd].y == runs[offset].y) lowerEnd++;
+				joinRows(runs, parent, corners, upper, offset, offset, lowerEnd);
+			}
+
+			for(auto iter = strips[s].corners.begin(); iter != strips[s].corners.end(); iter++)
+			{
+				corners.push_back({iter->upper + offset, iter->lower + offset, iter->at});
+			}
+			vector<run_type>().swap(strips[s].runs);
+			vector<int>().swap(strips[s].parent);
+			vector<corner_type>().swap(strips[s].corners);
+			strips[s].firstRun = offset;
+			strips[s].lastRun = int(runs.size());
+		}
+
+		//A parent always comes before its children, so one pass in order points every run straight at its root
+		const int runCount = int(runs.size());
+		for(int i = 0; i < runCount; i++)
+		{
+			parent[i] = parent[parent[i]];
+		}
+
+		//The extent, size and hits of each group
+		vector<group_type> groups(runCount);
+		for(int i = 0; i < runCount; i++)
+		{
+			const run_type & run = runs[i];
+			group_type & group = groups[parent[i]];
+			if(parent[i] == i) group = {run.x0, run.x1, run.y, 0, 0, -1};
+
+			group.minX = std::min(group.minX, run.x0);
+			group.maxX = std::max(group.maxX, run.x1);
+			group.maxY = run.y;
+			group.cells += run.x1 - run.x0 + 1;
+			group.hits += run.hits;
+		}
+
+		//The runs of each group that isn't straight, as linked lists in row-major order
+		vector<int> next(runCount, -1);
+		for(int i = runCount - 1; i >= 0; i--)
+		{
+			group_type & group = groups[parent[i]];
+			if(group.maxY == runs[parent[i]].y || group.minX == group.maxX) continue;
+			next[i] = group.first;
+			group.first = i;
+		}
+
+		//Turn the groups into ships, each strip on its own thread again, then put the ships back together in order
+		inParallel([&](int s) { findShips(board, runs, parent, groups, next, strips[s]); });
+		for(int s = 0; s < threadCount; s++)
+		{
+			ships.insert(ships.end(), strips[s].ships.begin(), strips[s].ships.end());
+		}
+
+		vector<shipProblem_type> found;		//The groups that weren't straight, in row-major order
+		for(int s = 0; s < threadCount; s++)
+		{
+			found.insert(found.end(), strips[s].found.begin(), strips[s].found.end());
+		}
+
+		vector<shipProblem_type> touching;		//The corners where two different groups meet, in row-major order
+		for(auto iter = corners.begin(); iter != corners.end(); iter++)
+		{
+			if(parent[iter->upper] != parent[iter->lower]) touching.push_back({file_shipsTouching, iter->at});
+		}
+
+		const size_t firstProblem = problems.size();
+		problems.resize(firstProblem + found.size() + touching.size());
+		std::merge(found.begin(), found.end(), touching.begin(), touching.end(), problems.begin() + firstProblem, comesBefore);
+	}
+};
+
+namespace gameJournal		//The game journal format: a header, then fixed size records, one per event.  All numbers are little-endian
+{	//Header (16 bytes): "BSJL", version (16 bit), record size (16 bit), 8 bytes reserved
+	//Each record (16 bytes): event (8 bit), shot result (8 bit), 16 bits reserved, x, y, value (32 bit each)
+	//A board record (newBoard or checkpoint) is followed by 'x' bytes of the board in the binary level format, padded with zeros to a whole number of records
+	const char magic[4] = { 'B', 'S', 'J', 'L' };
+	const uint16_t version = 1;
+	const size_t headerSize = 16;
+	const size_t recordSize = 16;
+
+	enum event_type
+	{
+		newBoard,		//A board was generated or loaded, which starts a new game.  'value' is 0
+		checkpoint,		//The whole board, written every so often so replay can start near any turn, and after an undo.  'value' is the turn it was taken after, which
+						//after an undo is the earlier turn the game went back to (so the shots after it reuse the turns that were undone)
+		shot,			//A shot at (x, y), and what it did
+		shotsSet,		//The shots remaining were set to 'value'
+		allShipsDestroyed,	//#killall
+		eventCount
+	};
+
+	size_t paddedSize(size_t bytes) { return (bytes + recordSize - 1) / recordSize * recordSize; }
+
+	void putRecord(char * out, event_type event, int result, int32_t x, int32_t y, int32_t value)	//Encodes one record into the 16 bytes at 'out'
+	{
+		const uint32_t fields[4] = { uint32_t(event) | (uint32_t(result & 0xFF) << 8), uint32_t(x), uint32_t(y), uint32_t(value) };
+
+		if(binaryLevel::isLittleEndian()) std::memcpy(out, fields, recordSize);		//The record is already in the right byte order
+		else
+		{
+			for(int f = 0; f < 4; f++)
+			{
+				for(int i = 0; i < 4; i++) out[4 * f + i] = char((fields[f] >> (8 * i)) & 0xFF);
+			}
+		}
+	}
+};
+
+class journal_type		//An append-only journal of everything that changes a game board (shots, #setshots, #killall, new boards), written to a file in large blocks
+{	//Every 'checkpointInterval' shots the whole board is written as well, so journalReader_type can seek to a turn without replaying the game from its start
+	std::ofstream file;
+	vector<char> buffer;	//Events waiting to be written to the file, in buffer[0, used).  Only allocated while a file is open, as most journals never record anything
+	size_t used = 0;
+	int turn = 0;			//Shots recorded since the last new board
+	int checkpointInterval;
+
+	static const size_t bufferSize = 256 * 1024;
+
+	void append(gameJournal::event_type event, int result, int32_t x, int32_t y, int32_t value)
+	{
+		if(buffer.empty()) return;		//Not open, so there is nowhere to write it
+		if(used + gameJournal::recordSize > buffer.size()) flush();
+
+		gameJournal::putRecord(&buffer[used], event, result, x, y, value);
+		used += gameJournal::recordSize;
+	}
+
+	void appendBytes(const char * data, size_t length)
+	{
+		if(buffer.empty()) return;
+		if(used + length > buffer.size()) flush();
+
+		if(length > buffer.size()) file.write(data, std::streamsize(length));		//Too big for the buffer, so it goes straight to the file
+		else
+		{
+			std::memcpy(&buffer[used], data, length);
+			used += length;
+		}
+	}
+
+public:
+	journal_type(int _checkpointInterval = 64) : checkpointInterval(std::max(1, _checkpointInterval)) {}
+
+	~journal_type() { close(); }
+
+	journal_type(const journal_type &) = delete;
+	journal_type & operator=(const journal_type &) = delete;
+
+	errorstates open(string filename)		//Starts appending to 'filename' (after anything already recorded there).  Returns file_writeFailed if it can't be opened, or
+	{										//file_badFormat/file_badVersion if it isn't a journal this version writes (appending to it would make it unreadable)
+		close();
+
+		size_t existing = 0;
+		{
+			mappedFile_type current(filename);
+			if(current.isOpen()) existing = current.size();
+
+			if(existing > 0)
+			{
+				const char * data = current.data();
+				if(existing < gameJournal::headerSize || std::memcmp(data, gameJournal::magic, 4) != 0) return file_badFormat;
+				if(binaryLevel::get16(data + 4) != gameJournal::version || binaryLevel::get16(data + 6) != gameJournal::recordSize) return file_badVersion;
+				if((existing - gameJournal::headerSize) % gameJournal::recordSize != 0) return file_badFormat;		//Cut off partway through a record, so anything appended would be misread
+			}
+		}
+
+		file.open(filename, std::ios::binary | std::ios::app);
+		if(!file) return file_writeFailed;
+		buffer.resize(bufferSize);
+
+		if(existing == 0)		//A new journal, so it needs a header
+		{
+			char header[gameJournal::headerSize] = {};
+			std::memcpy(header, gameJournal::magic, 4);
+			header[4] = char(gameJournal::version & 0xFF);
+			header[5] = char(gameJournal::version >> 8);
+			header[6] = char(gameJournal::recordSize);
+			appendBytes(header, sizeof(header));
+		}
+		turn = 0;
+		return noerror;
+	}
+
+	bool isOpen() { return file.is_open(); }
+
+	errorstates flush()		//Writes everything recorded so far to the file.  Returns file_writeFailed if it couldn't be written
+	{
+		if(!file.is_open())
+		{
+			used = 0;		//Nowhere to write it
+			return noerror;
+		}
+
+		file.write(&buffer[0], std::streamsize(used));
+		file.flush();
+		used = 0;
+		return (file ? noerror : file_writeFailed);
+	}
+
+	void close()
+	{
+		if(!file.is_open()) return;
+		flush();
+		file.close();
+		vector<char>().swap(buffer);		//Gives the buffer's memory back
+	}
+
+	size_t getMemoryUsed() const { return sizeof(*this) + buffer.capacity(); }		//Roughly how many bytes the journal is using
+
+	void recordShot(coordi at, shotResult result)		//Records a shot.  Returns quickly: the event goes into the buffer, and only every so often is the buffer written out
+	{
+		turn++;
+		append(gameJournal::shot, result, at.x, at.y, turn);
+	}
+
+	void recordShotsSet(int value) { append(gameJournal::shotsSet, 0, 0, 0, value); }
+	void recordAllShipsDestroyed() { append(gameJournal::allShipsDestroyed, 0, 0, 0, 0); }
+
+	bool checkpointDue() { return turn % checkpointInterval == 0; }		//True right after a shot that should be followed by a checkpoint
+	void rewind(int shots) { turn = std::max(0, turn - shots); }		//Takes back the last 'shots' turns, after they were undone.  The next board recorded is at the earlier turn
+
+	void recordBoard(bool isNewBoard, const string & level)		//Records a whole board, 'level' in the binary level format.  A new board starts a new game (turn 0)
+	{
+		if(isNewBoard) turn = 0;
+		append(isNewBoard ? gameJournal::newBoard : gameJournal::checkpoint, 0, int32_t(level.size()), 0, turn);
+
+		const char padding[gameJournal::recordSize] = {};
+		appendBytes(level.data(), level.size());
+		appendBytes(padding, gameJournal::paddedSize(level.size()) - level.size());
+	}
+};
+
+struct boardSnapshot_type		//A point in a game board's history that the board can be rolled back to (see gameBoard_type::snapshot())
+{
+	size_t position = 0;		//The number of changes in the history when it was taken
+	uint64_t serial = 0;		//The serial number of the last of those changes, so the snapshot is known to be stale once they have been undone or the board replaced
+};
+
+class gameBoard_type		//A game board.  Set up as a class so 2-person play is possible (not currently implimented), and also to add data validation functions (i.e. don't let things read/write to [-1, 6], etc)
+{							//The board also contains some other gameplay data, i.e. number of shots remaining
+public:
+	gameBoard_type(coordi boardSize) {	//Creates a new gameBoard element with 'size' dimensions
+		size = boardSize;
+		board.resize(size);		//Every cell starts out as ocean
+	}
+
+private:
+	bitBoard_type board;		//The game board, indexed by x and y coordinates
+	coordi size;				//The dimensions of the game board
+
+	int shotsMax = 60;	//The maximum number of shots the player can take
+	int shots = shotsMax;		//The number of shots the player has left
+
+	//Fleet accounting, kept up to date as the board changes so the win check doesn't have to scan the board
+	int liveShipCells = 0;				//The number of ship cells that haven't been hit
+	vector<shipRecord_type> ships;		//Every ship placed by createShip(), or found in the cells of a board loaded from a text level by identifyShips()
+	int lastSunkShip = -1;				//The index in 'ships' of the ship sunk by the last shot, or -1 if the last shot didn't sink anything
+
+	//Zobrist hashes of the cells (see zobrist), kept up to date as cells change.  getHash() adds the key for the board's size
+	uint64_t cellHash = 0;
+	uint64_t cellCheck = 0;				//The independent second hash, for telling positions with the same hash apart
+
+	vector<uint64_t> placementScratch;	//Working space for createShip(), kept between calls so placing a ship doesn't allocate
+	vector<char> renderedRow;			//Working space for print(), one row of glyphs
+
+	static const int viewRows = 25;		//The number of cells down the part of the board that fits on the screen
+	static const int frameRight = 52;	//The screen column of the right edge of the board's frame.  The left edge moves over to make room for the row numbers
+	coordi view = coordi(0, 0);			//The cell in the top left corner of the part of the board on the screen
+
+	journal_type * journal = nullptr;	//Where changes to the board are recorded, if anywhere
+	string journalScratch;				//The board in the binary level format, for the journal's checkpoints
+
+	void recordBoard(bool isNewBoard)		//Writes the whole board to the journal
+	{
+		journalScratch.clear();
+		saveToMemory(journalScratch);
+		journal->recordBoard(isNewBoard, journalScratch);
+	}
+
+	void findFreeCells(uint64_t * free)		//Fills 'free' (laid out like a plane of the board) with a bit for every cell that doesn't contain a ship.  Bits past the edge of the board are never set.
+	{
+		const int rowWords = board.getRowWords();
+		const int lastBits = size.x - (rowWords - 1) * bitBoard_type::bitsPerWord;		//The number of cells used in the last word of each row
+		const uint64_t lastMask = (lastBits == bitBoard_type::bitsPerWord ? ~uint64_t(0) : (uint64_t(1) << lastBits) - 1);
+
+		for(int y = 0; y < size.y; y++)
+		{
+			for(int w = 0; w < rowWords; w++)
+			{
+				free[y * rowWords + w] = ~board.getWord(bitBoard_type::shipPlane, w, y);
+			}
+			free[y * rowWords + rowWords - 1] &= lastMask;
+		}
+	}
+
+	void recountShips()		//Recomputes 'liveShipCells' from the board itself, used after the board has been changed in bulk
+	{
+		liveShipCells = board.countLiveShipCells();
+	}
+
+	void toggleKeys(int x, int y, int planes)	//XORs the keys for cell (x, y) in each of 'planes' (bits as zobrist::planeBits() gives them) into the hashes
+	{
+		for(; planes != 0; planes &= planes - 1)
+		{
+			const int plane = util::countTrailingZeros(uint64_t(planes));
+			cellHash ^= zobrist::key(plane, x, y, zobrist::hashSeed);
+			cellCheck ^= zobrist::key(plane, x, y, zobrist::checkSeed);
+		}
+	}
+
+	void rehash()		//Recomputes the hashes from the board itself, used after the board has been changed in bulk.  Takes time in proportion to the cells with something in them
+	{
+		cellHash = 0;
+		cellCheck = 0;
+		for(int plane = 0; plane < bitBoard_type::planeCount; plane++)
+		{
+			board.forEachWord(bitBoard_type::plane_type(plane), 0, size.y, [&](int w, int y, uint64_t word)
+			{
+				for(; word != 0; word &= word - 1)
+				{
+					const int x = w * bitBoard_type::bitsPerWord + util::countTrailingZeros(word);
+					const int bit = 1 << plane;
+					//Only the bits the cell's contents stand for count (a loaded file can set others), so the hash depends on nothing but what getCell() returns
+					if(x < size.x && (zobrist::planeBits(board.getCell(x, y)) & bit) != 0) toggleKeys(x, y, bit);
+				}
+			});
+		}
+	}
+
+	//Index of which ships cover which cells, so a hit finds its ship without looking at every ship.  A horizontal ship is filed under each word of its row it
+	//crosses, a vertical one under each block of bitsPerWord rows of its column it crosses, in a hash table with open addressing.  It's rebuilt the first time
+	//it's needed after the ships have changed, so placing or loading a fleet doesn't keep it up to date ship by ship
+	struct shipSlot_type
+	{
+		uint64_t key;		//The word or block, from shipBucket()
+		int ship;			//The index in 'ships', or -1 if the slot is empty
+	};
+	vector<shipSlot_type> shipIndex;
+	bool shipIndexStale = true;
+	static const size_t shipIndexMinShips = 16;		//Fleets smaller than this are quicker to search one ship at a time
+
+	static uint64_t shipBucket(bool vertical, int x, int y)
+	{
+		if(vertical) return (uint64_t(1) << 63) | (uint64_t(uint32_t(x)) << 32) | uint32_t(y / bitBoard_type::bitsPerWord);
+		return (uint64_t(uint32_t(y)) << 32) | uint32_t(x / bitBoard_type::bitsPerWord);
+	}
+
+	size_t shipSlotOf(uint64_t key) const { return size_t((key * 0x9E3779B97F4A7C15ULL) >> 32) & (shipIndex.size() - 1); }
+
+	static void shipBuckets(const shipRecord_type& record, bool& vertical, int& first, int& last)	//The range of words or blocks a ship is filed under
+	{
+		const coordi step = util::toStep(record.direction);
+		const coordi end(record.start.x + step.x * (record.length - 1), record.start.y + step.y * (record.length - 1));
+		vertical = (step.y != 0);
+		first = (vertical ? std::min(record.start.y, end.y) : std::min(record.start.x, end.x)) / bitBoard_type::bitsPerWord;
+		last = (vertical ? std::max(record.start.y, end.y) : std::max(record.start.x, end.x)) / bitBoard_type::bitsPerWord;
+	}
+
+	void rebuildShipIndex()
+	{
+		bool vertical;
+		int first, last;
+		size_t entries = 0;
+		for(auto iter = ships.begin(); iter != ships.end(); iter++)
+		{
+			shipBuckets(*iter, vertical, first, last);
+			entries += last - first + 1;
+		}
+
+		size_t capacity = 16;
+		while(capacity < entries * 2) capacity *= 2;
+		shipIndex.assign(capacity, shipSlot_type { 0, -1 });
+
+		for(int i = 0; i < int(ships.size()); i++)
+		{
+			shipBuckets(ships[i], vertical, first, last);
+			for(int bucket = first; bucket <= last; bucket++)
+			{
+				const uint64_t key = (vertical ? shipBucket(true, ships[i].start.x, bucket * bitBoard_type::bitsPerWord) : shipBucket(false, bucket * bitBoard_type::bitsPerWord, ships[i].start.y));
+				size_t slot = shipSlotOf(key);
+				while(shipIndex[slot].ship >= 0) slot = (slot + 1) & (shipIndex.size() - 1);
+				shipIndex[slot] = shipSlot_type { key, i };
+			}
+		}
+		shipIndexStale = false;
+	}
+
+	int findShip(coordi pos)		//Returns the index in 'ships' of the ship with a cell at 'pos', or -1 if there isn't one
+	{
+		if(ships.size() < shipIndexMinShips)
+		{
+			for(int i = 0; i < int(ships.size()); i++)
+			{
+				if(ships[i].covers(pos)) return i;
+			}
+			return -1;
+		}
+
+		if(shipIndexStale) rebuildShipIndex();
+		for(int vertical = 0; vertical < 2; vertical++)
+		{
+			const uint64_t key = shipBucket(vertical != 0, pos.x, pos.y);
+			for(size_t slot = shipSlotOf(key); shipIndex[slot].ship >= 0; slot = (slot + 1) & (shipIndex.size() - 1))
+			{
+				if(shipIndex[slot].key == key && ships[shipIndex[slot].ship].covers(pos)) return shipIndex[slot].ship;
+			}
+		}
+		return -1;
+	}
+
+	//Undo history: every change made while playing on the board (shots, setShots(), destroyAllShips()) since it was set up, with what the change overwrote.
+	//A snapshot is only a position in the history, so taking one copies nothing, and rolling back to it undoes the changes after it one at a time, newest first
+	struct undoRecord_type
+	{
+		coordi at;					//The cell that was changed, or (-1, -1) if none was
+		cellContents_type before;	//What the cell held
+		int shots;					//The shots left before the change
+		int lastSunkShip;			//'lastSunkShip' before the change
+		int ship;					//The index in 'ships' of the ship whose hits were changed, or -1 if none were
+		int shipHits;				//That ship's hits before the change
+		bool shot;					//Whether the change was a shot, which the journal counts as a turn
+		uint64_t serial;			//Counts up with every change recorded, and never repeats for the same board object
+	};
+	vector<undoRecord_type> history;
+	uint64_t historySerial = 0;		//The serial number of the newest change recorded
+	uint64_t historyStart = 0;		//The serial number given to the start of the history, for snapshots of the board before anything was changed
+
+	//Adds what cell 'at' holds now ('before', which the caller has already read) and what ship 'shipIndex' holds now (and the shots left) to the history, before they're changed
+	void recordChange(coordi at, cellContents_type before, int shipIndex = -1, bool shot = false)
+	{
+		history.push_back({ at, before, shots, lastSunkShip, shipIndex, (shipIndex >= 0 ? ships[shipIndex].hits : 0), shot, ++historySerial });
+	}
+
+	void forgetHistory()	//Starts the history again, once the board has been replaced or rebuilt.  Every snapshot taken before goes stale
+	{
+		history.clear();
+		historyStart = ++historySerial;
+	}
+
+	//File loader flags
+	vector<errorstates> fileErrors;
+	vector<shipProblem_type> shipProblems;		//What identifyShips() found wrong with how the ships on the last board loaded are laid out
+
+public:
+	void identifyShips()	//Works out the ship records from the cells of the board, for boards loaded without any (see shipLabeler_type)
+	{
+		ships.clear();
+		shipProblems.clear();
+		shipLabeler_type::label(board, ships, shipProblems);
+		shipIndexStale = true;
+	}
+
+	void emptyBoard()		//Empties the game board.  WILL RESULT IN DATA LOSS (duh)
+	{
+		board.clear();
+		forgetHistory();
+		ships.clear();
+		shipIndexStale = true;
+		liveShipCells = 0;
+		cellHash = 0;
+		cellCheck = 0;
+		lastSunkShip = -1;
+	}
+
+	coordi getBoardSize() { return size; }
+
+	void setBoardSize(coordi boardSize)		//Changes the dimensions of the board.  Empties the board and scrolls back to the top left
+	{
+		size = boardSize;
+		board.resize(size);
+		emptyBoard();
+		view = coordi(0, 0);
+	}
+
+	size_t getMemoryUsed() { return board.getMemoryUsed(); }	//Roughly how many bytes the cells of the board are using
+
+	coordi getView() { return view; }
+
+	int rowLabelWidth() const		//The number of characters the row numbers down the side of the board need (at least 2)
+	{
+		int width = 1;
+		for(int last = size.y - 1; last >= 10; last /= 10) width++;
+		return std::max(2, width);
+	}
+
+	int viewColumns() const { return (frameRight - rowLabelWidth()) / 2; }	//The number of cells across the part of the board that fits on the screen, 25 unless the row numbers are wide
+
+	bool isScrollable() { return size.x > viewColumns() || size.y > viewRows; }	//Returns true if the board doesn't fit on the screen
+
+	void scrollTo(coordi corner)	//Moves the part of the board on the screen so 'corner' is in its top left, or as close as it can get without going past the edge of the board
+	{
+		view.x = std::max(0, std::min(corner.x, size.x - viewColumns()));
+		view.y = std::max(0, std::min(corner.y, size.y - viewRows));
+	}
+
+	void centerOn(coordi pos) { scrollTo(coordi(pos.x - viewColumns() / 2, pos.y - viewRows / 2)); }	//Moves the part of the board on the screen so 'pos' is in the middle of it
+
+	void scrollToShow(coordi pos)	//Centers the screen on 'pos' if it isn't on the screen already
+	{
+		if(pos.x < view.x || pos.x >= view.x + viewColumns() || pos.y < view.y || pos.y >= view.y + viewRows) centerOn(pos);
+	}
+
+	bool isValidPosition(coordi pos)		//Returns true when 'pos' is a valid position within the game board
+	{
+		return (0 <= pos.x && pos.x < size.x) && (0 <= pos.y && pos.y < size.y);
+	}
+
+	errorstates checkPosition(coordi pos)		//Returns board_badX/board_badY if 'pos' is off the board, noerror if it's on it
+	{
+		if(!(0 <= pos.x && pos.x < size.x)) return board_badX;
+		if(!(0 <= pos.y && pos.y < size.y)) return board_badY;
+		return noerror;
+	}
+
+	outcome_type<cellContents_type> getContents(coordi pos)	//Returns the contents of a cell, after making sure that the cell is valid
+	{
+		errorstates error = checkPosition(pos);
+		if(error != noerror) return error;
+		return board.getCell(pos.x, pos.y);
+	}
+
+	cellContents_type getContentsUnchecked(coordi pos) { return board.getCell(pos.x, pos.y); }	//Returns the contents of a cell the caller has already made sure is on the board
+
+	errorstates setContents(coordi pos, cellContents_type cell)		//Sets the contents of a cell, after making sure that the cell is valid.  Returns board_badX/board_badY (and changes nothing) if it isn't
+	{	//This is for building boards, so it isn't recorded in the history, and snapshots taken before go stale
+		errorstates error = checkPosition(pos);
+		if(error == noerror)
+		{
+			setContentsUnchecked(pos, cell);
+			forgetHistory();
+		}
+		return error;
+	}
+
+	void setContentsUnchecked(coordi pos, cellContents_type cell)	//Sets the contents of a cell the caller has already made sure is on the board
+	{
+		//Keep the live ship count and the hashes in step with the cell being overwritten
+		const cellContents_type before = board.getCell(pos.x, pos.y);
+		if(before == ship) liveShipCells--;
+		if(cell == ship) liveShipCells++;
+		toggleKeys(pos.x, pos.y, zobrist::planeBits(before) ^ zobrist::planeBits(cell));
+
+		board.setCell(pos.x, pos.y, cell);
+	}
+
+	int getLiveShipCells() { return liveShipCells; }
+
+	//The Zobrist hash of the cells and the size of the board: boards with the same cells have the same hash, whatever order they were changed in.  The shots left aren't part of it.
+	//getHashCheck() is a second hash of the same, independent of the first, for checking that two boards with the same hash really are the same
+	uint64_t getHash() { return cellHash ^ zobrist::key(bitBoard_type::planeCount, size.x, size.y, zobrist::hashSeed); }
+	uint64_t getHashCheck() { return cellCheck ^ zobrist::key(bitBoard_type::planeCount, size.x, size.y, zobrist::checkSeed); }
+	const vector<shipRecord_type> & getShips() { return ships; }
+
+	const shipRecord_type * getLastSunkShip()		//Returns the ship sunk by the last shot fired, or nullptr if that shot didn't sink a ship
+	{
+		if(lastSunkShip < 0) return nullptr;
+		return &ships[lastSunkShip];
+	}
+
+	//Places a ship of 'length' at 'startingPoint' in 'direction'.  Nothing is placed if the ship would leave the board (board_badX/board_badY is returned) or cross another ship (board_gen_shipExists is returned)
+	errorstates createShip(coordi startingPoint, direction_type direction = north, int length = 1)
+	{
+		if(length < 1) return noerror;
+
+		const coordi step = util::toStep(direction);
+		const coordi end(startingPoint.x + step.x * (length - 1), startingPoint.y + step.y * (length - 1));	//The last cell of the ship
+
+		//The ship is a straight line, so it's on the board if both ends are
+		errorstates error = checkPosition(startingPoint);
+		if(error == noerror) error = checkPosition(end);
+		if(error != noerror) return error;
+
+		coordi pos = startingPoint;		//The current point
+
+		for(int i = 0; i < length; i++, pos += step)		//Check for other ships
+		{
+			if(getContentsUnchecked(pos) == ship)
+			{
+				generatorLoopNum++;
+				return board_gen_shipExists;
+			}
+		}
+
+		pos = startingPoint;
+		forgetHistory();		//The board is being built, not played on
+
+		for(int i = 0; i < length; i++, pos += step)		//Place the ship
+		{
+			setContentsUnchecked(pos, ship);
+		}
+
+		shipRecord_type record;
+		record.start = startingPoint;
+		record.direction = direction;
+		record.length = length;
+		record.hits = 0;
+		ships.push_back(record);
+		shipIndexStale = true;
+		return noerror;
+	}
+
+	//Fills 'starts' (laid out like a plane of the board: starts[y * rowWords + w]) with the cells where a ship of 'length' can start without leaving the board or overlapping another ship.
+	//'free' is the mask of cells without a ship, from findFreeCells().  'horizontal' picks between ships running east and ships running south from the start cell.  Returns the number of possible starts.
+	int findShipStarts(int length, bool horizontal, const uint64_t * free, uint64_t * starts)
+	{
+		const int rowWords = board.getRowWords();
+		const int planeWords = size.y * rowWords;
+
+		for(int i = 0; i < planeWords; i++)
+		{
+			starts[i] = free[i];
+		}
+
+		//A start is valid when the next 'length' - 1 cells east (or south) are free as well.  Rather than checking one cell at a time, the length
+		//of the run checked doubles each pass: after a pass, a bit is set if the 'checked' cells starting there are all free.
+		int checked = 1;
+		while(checked < length)
+		{
+			const int shift = std::min(checked, length - checked);
+
+			if(!horizontal)
+			{	//Rows below the bottom of the board count as taken.  Going top to bottom only ever reads rows that haven't been changed yet this pass.
+				const int shiftWords = shift * rowWords;
+				for(int i = 0; i < planeWords; i++)
+				{
+					starts[i] &= (i + shiftWords < planeWords ? starts[i + shiftWords] : 0);
+				}
+			}
+			else if(rowWords == 1)
+			{	//The whole row fits in one word (any board up to 64 wide), which is the common case
+				for(int y = 0; y < size.y; y++)
+				{
+					starts[y] &= (shift < bitBoard_type::bitsPerWord ? starts[y] >> shift : 0);
+				}
+			}
+			else
+			{	//Words past the edge of the board count as taken
+				const int wordShift = shift / bitBoard_type::bitsPerWord;
+				const int bitShift = shift % bitBoard_type::bitsPerWord;
+
+				for(int y = 0; y < size.y; y++)
+				{
+					uint64_t * rowStarts = starts + y * rowWords;
+					for(int w = 0; w < rowWords; w++)
+					{
+						uint64_t shifted = (w + wordShift < rowWords ? rowStarts[w + wordShift] >> bitShift : 0);
+						if(bitShift > 0 && w + wordShift + 1 < rowWords) shifted |= rowStarts[w + wordShift + 1] << (bitBoard_type::bitsPerWord - bitShift);
+						rowStarts[w] &= shifted;
+					}
+				}
+			}
+
+			checked += shift;
+		}
+
+		int count = 0;
+		for(int i = 0; i < planeWords; i++)
+		{
+			count += util::popcount(starts[i]);
+		}
+		return count;
+	}
+
+	static const int quickPlacementTries = 8;		//How many random places createShip() tries before it finds every place the ship fits
+
+	bool createShip(int length) { return createShip(length, util::threadRandom()); }
+
+	bool createShip(int length, random_type & random)		//Randomly places a ship of 'length', using 'random'.  Every position the ship fits in is equally likely.  Returns false (and places nothing) if there is no room for the ship
+	{
+		if(length < 1) return false;
+
+		if(board.isSparse()) return createShipSparse(length, random);
+
+		//Most boards are mostly ocean, so a few random tries usually find room without mapping the free cells.  A pick that only stands when the tries miss is still
+		//uniform, since the tries themselves pick uniformly among the places the ship fits
+		if(createShipSparse(length, random, quickPlacementTries)) return true;
+
+		const int planeWords = size.y * board.getRowWords();
+		placementScratch.resize(3 * planeWords);
+
+		uint64_t * free = &placementScratch[2 * planeWords];
+		findFreeCells(free);
+
+		//Find every (position, direction) the ship fits in...  (ships of length 1 are the same in either direction, so they're only counted once)
+		int eastCount = findShipStarts(length, true, free, &placementScratch[0]);
+		int southCount = (length > 1 ? findShipStarts(length, false, free, &placementScratch[planeWords]) : 0);
+
+		if(eastCount + southCount == 0) return false;
+
+		//...then pick one of them, and find which word of the start masks it is in
+		int pick = random.range(0, eastCount + southCount - 1);
+
+		direction_type direction = east;
+		const uint64_t * starts = &placementScratch[0];
+		if(pick >= eastCount)
+		{
+			pick -= eastCount;
+			direction = south;
+			starts = &placementScratch[planeWords];
+		}
+
+		for(int i = 0; i < planeWords; i++)
+		{
+			int inWord = util::popcount(starts[i]);
+			if(pick < inWord)
+			{
+				int y = i / board.getRowWords();
+				int x = (i % board.getRowWords()) * bitBoard_type::bitsPerWord + util::selectBit(starts[i], pick);
+				createShip(coordi(x, y), direction, length);
+				return true;
+			}
+			pick -= inWord;
+		}
+
+		return false;	//Not reachable, the pick is always one of the starts counted
+	}
+
+	//Randomly places a ship of 'length' on a sparse board (too big to map the free cells of), by trying random positions until one is free.  Every position the ship fits in is
+	//still equally likely, but this gives up (returning false and placing nothing) after 'maxTries' overlaps, so it's only for oceans that are mostly empty
+	bool createShipSparse(int length, random_type & random, int maxTries = 1000)
+	{
+		//Each direction is picked in proportion to the number of starts that keep the ship on the board
+		const int64_t eastStarts = (length <= size.x ? int64_t(size.x - length + 1) * size.y : 0);
+		const int64_t southStarts = (length > 1 && length <= size.y ? int64_t(size.y - length + 1) * size.x : 0);
+		if(eastStarts + southStarts == 0) return false;
+
+		for(int i = 0; i < maxTries; i++)
+		{
+			int64_t pick = int64_t(random.below(uint64_t(eastStarts + southStarts)));
+			const bool horizontal = (pick < eastStarts);
+			if(!horizontal) pick -= eastStarts;
+
+			const int width = (horizontal ? size.x - length + 1 : size.x);
+			if(createShip(coordi(int(pick % width), int(pick / width)), (horizontal ? east : south), length) == noerror) return true;
+		}
+
+		return false;
+	}
+
+	bool placeFleet(const vector<int> & lengths, int maxAttempts = 100) { return placeFleet(lengths, util::threadRandom(), maxAttempts); }
+
+	bool placeFleet(const vector<int> & lengths, random_type & random, int maxAttempts = 100)		//Empties the board and randomly places a ship for each of 'lengths'.  Never throws.
+	{	//Returns false if the fleet could not be placed, either because it cannot fit at all or because 'maxAttempts' layouts in a row ran out of room
+		profiling::scopedTimer_type timer(profiling::phase_generate);
+		int64_t fleetCells = 0;
+		for(auto iter = lengths.begin(); iter != lengths.end(); iter++)
+		{
+			fleetCells += *iter;
+		}
+
+		if(fleetCells > int64_t(size.x) * size.y) return false;	//There aren't enough cells on the board for the fleet
+
+		//Place the longest ships first, while there is the most room for them
+		vector<int> order = lengths;
+		std::sort(order.begin(), order.end(), [](int a, int b) { return a > b; });
+
+		for(int attempt = 0; attempt < maxAttempts; attempt++)
+		{
+			emptyBoard();
+
+			bool placed = true;
+			for(auto iter = order.begin(); iter != order.end() && placed; iter++)
+			{
+				placed = createShip(*iter, random);
+			}
+
+			if(placed)
+			{
+				if(journal != nullptr) recordBoard(true);
+				return true;
+			}
+
+			generatorLoopNum++;		//The ships placed so far left no room for the rest, so start over
+		}
+
+		emptyBoard();
+		return false;
+	}
+
+	int getShots() { return shots; }
+	int getMaxShots() { return shotsMax; }
+
+	void setShots(int value, bool force = false)	//Sets the number of shots remaining to 'value', if value > 0.  if 'force' == true the input validation is ovveridden
+	{
+		if(value > 0 || force)		//If the number of shots remaning is greater than 0, or force (as in force setting) is enabled, set it to the value
+		{
+			recordChange(coordi(-1, -1), ocean);
+			shots = value;
+			if(journal != nullptr) journal->recordShotsSet(value);
+		}
+	}
+
+	void setJournal(journal_type * _journal, bool startGame = false)		//Starts recording changes to the board in '_journal' (nullptr to stop).  The journal has to outlive the board, or be detached first
+	{	//If 'startGame' is true, the board as it is now is recorded as the start of a new game
+		journal = _journal;
+		if(journal != nullptr && startGame) recordBoard(true);
+	}
+
+	journal_type * getJournal() { return journal; }
+
+	boardSnapshot_type snapshot()	//Returns the board as it is now, to roll back to with rollback().  Copies nothing, however big the board is
+	{
+		boardSnapshot_type now;
+		now.position = history.size();
+		now.serial = (history.empty() ? historyStart : history.back().serial);
+		return now;
+	}
+
+	//Undoes every change made since 'to' was taken, newest first, so the board is as it was then.  Snapshots taken after 'to' go stale, 'to' itself can be rolled
+	//back to again (so a search can try one move after another from the same position).  Returns board_staleSnapshot (and changes nothing) if 'to' is stale:
+	//the board has been replaced or rebuilt since it was taken, or it has been rolled back to before it
+	errorstates rollback(boardSnapshot_type to)
+	{
+		if(to.position > history.size() || to.serial != (to.position == 0 ? historyStart : history[to.position - 1].serial)) return board_staleSnapshot;
+		if(to.position == history.size()) return noerror;
+
+		int shotsUndone = 0;
+		while(history.size() > to.position)
+		{
+			const undoRecord_type & change = history.back();
+			if(change.at.x >= 0) setContentsUnchecked(change.at, change.before);
+			if(change.ship >= 0) ships[change.ship].hits = change.shipHits;
+			shots = change.shots;
+			lastSunkShip = change.lastSunkShip;
+			shotsUndone += change.shot;
+			history.pop_back();
+		}
+
+		if(journal != nullptr)		//The journal only records changes going forwards, so it's given the board as it is now, at the turn it was at then
+		{
+			journal->rewind(shotsUndone);
+			recordBoard(false);
+		}
+		return noerror;
+	}
+
+	size_t getHistoryLength() { return history.size(); }	//The number of changes that can be undone
+
+	//This is the equivalent to FleetSunk() as mentioned in the homework.  I've called it something else to wrap the shot-checking in and to make what it does clearer.
+	gameState_type checkWinLoss()			//Checks the game data for win/loss conditions.  Returns 'win' or 'lose' if the game is over, and 'running' if it isn't
+	{
+		profiling::scopedTimer_type timer(profiling::phase_winCheck);
+		if(liveShipCells == 0) return win;	//If there are no ships left on the board, the player wins (even if that took their last shot)
+
+		if(shots <= 0)	//If the player is out of shots (Loss condition)
+		{
+			return lose;
+		}
+
+		return running;
+	}
+
+	outcome_type<shotResult> fire(coordi at)	//Attempts to fire at 'at', and returns the restult as a shotResult type.  Returns board_badX/board_badY (without using a shot) if 'at' is off the board
+	{
+		profiling::scopedTimer_type timer(profiling::phase_fire);
+		errorstates error = checkPosition(at);
+		if(error != noerror) return error;
+
+		if(shots <= 0)		//If we have no shots remaining, we cannot fire.  (checkWinLoss() will report the loss)
+		{
+			return noAmmo;
+		}
+
+		cellContents_type cell = getContentsUnchecked(at);
+		const int shipIndex = (cell == ship ? findShip(at) : -1);
+		recordChange(at, cell, shipIndex, true);		//Even a shot at a cell already fired at uses up a shot, so every shot can be undone
+
+		shots--;
+		lastSunkShip = -1;
+		shotResult result;
+
+		switch(cell)
+		{
+			case ship:
+				setContentsUnchecked(at, destroyed_ship);
+				if(shipIndex >= 0)
+				{
+					ships[shipIndex].hits++;
+					if(ships[shipIndex].isSunk()) lastSunkShip = shipIndex;
+				}
+				result = hit;
+				break;
+
+			case destroyed_ship:
+				result = alreadyFired;
+				break;
+
+			case shot_miss:
+				result = alreadyFired;
+				break;
+
+			case ocean:
+				setContentsUnchecked(at, shot_miss);
+				result = miss;
+				break;
+
+			default:
+				setContentsUnchecked(at, shot_miss);
+				result = miss;
+				break;
+				//If we don't have a case for the cell, assume it's data is bad and set it as a missed shot
+		}
+
+		if(journal != nullptr)
+		{
+			journal->recordShot(at, result);
+			if(journal->checkpointDue()) recordBoard(false);
+		}
+		return result;
+	}
+
+	outcome_type<shotResult> fire(char _let, int _num)		//Attempts to convert the letter and number to coordinates, and returns the restult as a shotResult type
+	{
+		return fire(coordi(toupper(_let) - 'A', _num));		//the letter coordinate is determined by toupper(_let) - 'A' because that means when _let == 'A', the result will be 0
+	}
+
+	//Decodes the board from the text in 'data' (the same format as the level files), starting at 'offset', straight into the board's storage.
+	//'offset' is moved past the lines that were used, so several boards stored one after another (a level pack) can be read from one buffer.
+	void loadFromMemory(const char * data, size_t length, size_t & offset)
+	{
+		fileErrors.clear();		//Only report the errors from this file
+		board.clear();			//Only the words with something in them are stored, the rest is left as ocean
+		forgetHistory();
+
+		//Load each line from the file, and store it in each row
+		for(int y = 0; y < size.y; y++)
+		{
+			//Find the end of the line.  A line that isn't ended by a newline is the end of the file.
+			const char * line = data + offset;
+			const char * newline = (offset < length ? (const char *) std::memchr(line, '\n', length - offset) : nullptr);
+			size_t lineLength = (newline != nullptr ? size_t(newline - line) : length - offset);
+			offset += lineLength + (newline != nullptr ? 1 : 0);
+
+			if(lineLength > 0 && line[lineLength - 1] == '\r') lineLength--;	//Windows line endings
+
+			if(newline != nullptr || y == (size.y - 1))	//If the file ends before we're finished reading data (we expect the file to end on the last line, hence the y == size.y - 1)
+			{	//If the line from the file was loaded successfully, decode the cells a word at a time.  Spaces are ignored.
+				int cells = 0;		//The number of cells in the line (which may be more than fit on the board)
+				uint64_t ships = 0, hits = 0, misses = 0;
+
+				for(size_t i = 0; i < lineLength; i++)
+				{
+					const char token = line[i];
+					if(token == ' ') continue;
+
+					if(cells < size.x)
+					{
+						const uint64_t bit = uint64_t(1) << (cells % bitBoard_type::bitsPerWord);
+						if(token == '#' || token == 'H') ships |= bit;		//Anything that isn't a ship, a hit or a miss is ocean
+						if(token == 'H') hits |= bit;
+						if(token == 'M') misses |= bit;
+
+						if(cells % bitBoard_type::bitsPerWord == bitBoard_type::bitsPerWord - 1)	//The word is full, store it
+						{
+							const int w = cells / bitBoard_type::bitsPerWord;
+							board.setWord(bitBoard_type::shipPlane, w, y, ships);
+							board.setWord(bitBoard_type::hitPlane, w, y, hits);
+							board.setWord(bitBoard_type::missPlane, w, y, misses);
+							ships = hits = misses = 0;
+						}
+					}
+					cells++;
+				}
+
+				//Store the partly filled word (the rest of the row is already ocean)
+				const int w = std::min(cells, size.x) / bitBoard_type::bitsPerWord;
+				if(w < board.getRowWords())
+				{
+					board.setWord(bitBoard_type::shipPlane, w, y, ships);
+					board.setWord(bitBoard_type::hitPlane, w, y, hits);
+					board.setWord(bitBoard_type::missPlane, w, y, misses);
+				}
+
+				if(cells > size.x)	//If the data from the file is larger than expected
+				{
+					fileErrors.push_back(file_lineTooLong);
+				}
+				else if(cells < size.x)	//If the data from the file is shorter than expected
+				{
+					fileErrors.push_back(file_lineTooShort);
+
+					for(int x = cells; x < size.x; x++)		//One more for every cell that was missing (and filled in with ocean)
+					{
+						fileErrors.push_back(file_lineTooShort);
+					}
+				}
+			}
+			else
+			{
+				//If the line wasn't loaded properly, set a error flag and leave the row as ocean
+				fileErrors.push_back(file_eof);
+			}
+		}
+
+		identifyShips();		//The file only describes cells, so the ships have to be found in them
+		lastSunkShip = -1;
+		recountShips();
+		rehash();
+	}
+
+	//Loads the game board from the text level in 'file'.  Returns file_notFound if the file isn't open.  This is the fallback for streams that can't be mapped: the rest
+	//of the stream is copied into memory first, and binary levels aren't recognised.  Everything in the game loads through loadFromFile(string) instead
+	errorstates loadFromFile(ifstream & file)
+	{
+		if(!file)
+		{
+			//File does not exist
+			return file_notFound;
+		}
+
+		profiling::scopedTimer_type timer(profiling::phase_load);
+
+		//Read the rest of the file in one go, then decode it
+		string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		profiling::count(profiling::counter_levelBytes, (long long)contents.size());
+		size_t offset = 0;
+		loadFromMemory(contents.data(), contents.size(), offset);
+
+		if(journal != nullptr) recordBoard(true);
+		return noerror;
+	}
+
+	errorstates loadFromFile(string filename)		//Loads the game board from a file, 'filename'.  The file is memory mapped and decoded in place, without being copied
+	{	//Binary levels (see binaryLevel) are recognised by their header, anything else is read as a text level.  Returns file_notFound if the file can't be opened, or loadFromBinary()'s error
+		profiling::scopedTimer_type timer(profiling::phase_load);
+		mappedFile_type file(filename);
+		if(!file.isOpen()) return file_notFound;
+		profiling::count(profiling::counter_levelBytes, (long long)file.size());
+
+		errorstates error = noerror;
+		if(binaryLevel::isBinaryLevel(file.data(), file.size())) error = loadFromBinary(file.data(), file.size());
+		else
+		{
+			size_t offset = 0;
+			loadFromMemory(file.data(), file.size(), offset);
+		}
+
+		if(error == noerror && journal != nullptr) recordBoard(true);
+		return error;
+	}
+
+	void saveToMemory(string & out)		//Appends the board, in the binary level format, to 'out'.  Sparse boards are written as their tiles, so the level is no bigger than the board is in memory
+	{
+		const bool tiled = board.isSparse();
+		const vector<bitBoard_type::tile_type> & tiles = board.getTiles();
+		out.reserve(out.size() + binaryLevel::headerSize + ships.size() * binaryLevel::shipSize + (tiled ? 4 + tiles.size() * binaryLevel::tileSize : board.wordCount() * sizeof(uint64_t)));
+
+		out.append(binaryLevel::magic, 4);
+		binaryLevel::put16(out, (tiled ? binaryLevel::tiledVersion : binaryLevel::version));
+		binaryLevel::put16(out, binaryLevel::headerSize);
+		binaryLevel::put32(out, uint32_t(size.x));
+		binaryLevel::put32(out, uint32_t(size.y));
+		binaryLevel::put32(out, uint32_t(shots));
+		binaryLevel::put32(out, uint32_t(shotsMax));
+		binaryLevel::put32(out, uint32_t(ships.size()));
+		binaryLevel::put32(out, uint32_t(board.getRowWords()));
+
+		for(auto iter = ships.begin(); iter != ships.end(); iter++)
+		{
+			binaryLevel::put32(out, uint32_t(iter->start.x));
+			binaryLevel::put32(out, uint32_t(iter->start.y));
+			binaryLevel::put32(out, uint32_t(iter->direction));
+			binaryLevel::put32(out, uint32_t(iter->length));
+			binaryLevel::put32(out, uint32_t(iter->hits));
+		}
+
+		if(tiled)
+		{
+			binaryLevel::put32(out, uint32_t(tiles.size()));
+			for(auto iter = tiles.begin(); iter != tiles.end(); iter++)
+			{
+				binaryLevel::put32(out, uint32_t(iter->position.x));
+				binaryLevel::put32(out, uint32_t(iter->position.y));
+
+				size_t at = out.size();
+				out.resize(at + sizeof(iter->words));
+				for(int plane = 0; plane < bitBoard_type::planeCount; plane++)
+				{
+					for(int row = 0; row < bitBoard_type::tileRows; row++, at += sizeof(uint64_t))
+					{
+						binaryLevel::store64(&out[at], iter->words[plane][row]);
+					}
+				}
+			}
+		}
+		//The bit planes, exactly as they are stored in memory (on little-endian machines that's one copy)
+		else if(binaryLevel::isLittleEndian()) out.append((const char *) board.data(), board.wordCount() * sizeof(uint64_t));
+		else
+		{
+			for(size_t i = 0; i < board.wordCount(); i++)
+			{
+				binaryLevel::put64(out, board.data()[i]);
+			}
+		}
+	}
+
+	//Loads the board from 'data', in the binary level format.  The board takes on the size stored in the data.  Nothing is changed unless the data is valid
+	//Returns file_badFormat if it isn't a binary level, file_badVersion if it's from a different version, and file_badSize if the dimensions or lengths don't add up.
+	errorstates loadFromBinary(const char * data, size_t length)
+	{
+		if(length < binaryLevel::headerSize || std::memcmp(data, binaryLevel::magic, 4) != 0) return file_badFormat;
+		const uint16_t savedVersion = binaryLevel::get16(data + 4);
+		if(savedVersion != binaryLevel::version && savedVersion != binaryLevel::tiledVersion) return file_badVersion;
+
+		const uint32_t headerSize = binaryLevel::get16(data + 6);
+		const int32_t sizeX = int32_t(binaryLevel::get32(data + 8));
+		const int32_t sizeY = int32_t(binaryLevel::get32(data + 12));
+		const int32_t savedShots = int32_t(binaryLevel::get32(data + 16));
+		const int32_t savedShotsMax = int32_t(binaryLevel::get32(data + 20));
+		const uint32_t shipCount = binaryLevel::get32(data + 24);
+		const uint32_t rowWords = binaryLevel::get32(data + 28);
+
+		//Validate everything before touching the board
+		if(headerSize < binaryLevel::headerSize || sizeX < 1 || sizeY < 1 || sizeX > (1 << 20) || sizeY > (1 << 20)) return file_badSize;
+		if(savedShots < 0 || savedShotsMax < 0) return file_badFormat;
+		if(rowWords != uint32_t((sizeX + bitBoard_type::bitsPerWord - 1) / bitBoard_type::bitsPerWord)) return file_badSize;
+
+		const uint64_t planesOffset = uint64_t(headerSize) + uint64_t(shipCount) * binaryLevel::shipSize;
+		if(planesOffset + (savedVersion == binaryLevel::tiledVersion ? 4 : 0) > length) return file_badSize;
+
+		const char * planes = data + planesOffset;
+		const uint32_t tileCount = (savedVersion == binaryLevel::tiledVersion ? binaryLevel::get32(planes) : 0);
+		const uint64_t planeBytes = (savedVersion == binaryLevel::tiledVersion ? 4 + uint64_t(tileCount) * binaryLevel::tileSize
+			: uint64_t(bitBoard_type::planeCount) * uint64_t(sizeY) * rowWords * sizeof(uint64_t));
+		if(planesOffset + planeBytes != length) return file_badSize;
+
+		std::unordered_map<uint64_t, const char *> tileAt;		//The words of each tile, by (tileY << 32 | tileX).  A tile that is saved twice is loaded from its last copy
+		for(uint32_t i = 0; i < tileCount; i++)		//Every tile has to be on the board
+		{
+			const char * tile = planes + 4 + size_t(i) * binaryLevel::tileSize;
+			const uint32_t tileX = binaryLevel::get32(tile);
+			const uint32_t tileY = binaryLevel::get32(tile + 4);
+			if(tileX >= rowWords || tileY >= uint32_t((sizeY + bitBoard_type::tileRows - 1) / bitBoard_type::tileRows)) return file_badSize;
+			tileAt[(uint64_t(tileY) << 32) | tileX] = tile + 8;
+		}
+
+		auto savedWord = [&](int plane, uint32_t w, int y) -> uint64_t		//Word 'w' of row 'y' of 'plane', as it is in the file
+		{
+			if(savedVersion != binaryLevel::tiledVersion) return binaryLevel::get64(planes + ((uint64_t(plane) * uint64_t(sizeY) + uint64_t(y)) * rowWords + w) * sizeof(uint64_t));
+
+			auto found = tileAt.find((uint64_t(y / bitBoard_type::tileRows) << 32) | w);
+			if(found == tileAt.end()) return 0;
+			return binaryLevel::get64(found->second + (plane * bitBoard_type::tileRows + y % bitBoard_type::tileRows) * sizeof(uint64_t));
+		};
+
+		//Every cell has to be something setCell() could have stored: hits only on ships, misses only off them, and nothing past the end of a row
+		const uint64_t padding = (sizeX % bitBoard_type::bitsPerWord == 0 ? 0 : ~uint64_t(0) << (sizeX % bitBoard_type::bitsPerWord));		//The cells of a row's last word that are off the board
+		uint64_t shipCells = 0;
+		auto wordIsValid = [&](uint32_t w, int y)
+		{
+			const uint64_t shipBits = savedWord(bitBoard_type::shipPlane, w, y);
+			const uint64_t hitBits = savedWord(bitBoard_type::hitPlane, w, y);
+			const uint64_t missBits = savedWord(bitBoard_type::missPlane, w, y);
+			const uint64_t offBoard = (w + 1 == rowWords ? padding : 0);
+			shipCells += util::popcount(shipBits);
+			return ((shipBits | hitBits | missBits) & offBoard) == 0 && (hitBits & ~shipBits) == 0 && (missBits & shipBits) == 0;
+		};
+		if(savedVersion == binaryLevel::tiledVersion)
+		{
+			for(auto iter = tileAt.begin(); iter != tileAt.end(); iter++)
+			{
+				const uint32_t tileX = uint32_t(iter->first);
+				const int top = int(iter->first >> 32) * bitBoard_type::tileRows;
+				for(int y = top; y < std::min(top + bitBoard_type::tileRows, int(sizeY)); y++)		//Rows past the bottom of the board aren't loaded
+				{
+					if(!wordIsValid(tileX, y)) return file_badFormat;
+				}
+			}
+		}
+		else
+		{
+			for(int y = 0; y < sizeY; y++)
+			{
+				for(uint32_t w = 0; w < rowWords; w++)
+				{
+					if(!wordIsValid(w, y)) return file_badFormat;
+				}
+			}
+		}
+
+		//The ship records have to cover every ship cell exactly once, and each one's hits have to be the hits on its cells.  (Levels with no records at all are
+		//labeled when they're loaded instead)
+		vector<shipRecord_type> loadedShips(shipCount);
+		vector<uint64_t> recordCells;		//Every cell of every record, as (y << 32 | x), to find records that overlap
+		const char * shipData = data + headerSize;
+		for(uint32_t i = 0; i < shipCount; i++, shipData += binaryLevel::shipSize)
+		{
+			shipRecord_type & record = loadedShips[i];
+			record.start = coordi(int(binaryLevel::get32(shipData)), int(binaryLevel::get32(shipData + 4)));
+			record.direction = direction_type(binaryLevel::get32(shipData + 8));
+			record.length = int(binaryLevel::get32(shipData + 12));
+			record.hits = int(binaryLevel::get32(shipData + 16));
+
+			if(record.direction > west || record.length < 1 || record.hits < 0 || record.hits > record.length) return file_badFormat;
+			if(record.length > std::max(sizeX, sizeY)) return file_badFormat;
+
+			//The ship has to be on the board, and on ship cells all the way along
+			const coordi step = util::toStep(record.direction);
+			const coordi end(record.start.x + step.x * (record.length - 1), record.start.y + step.y * (record.length - 1));
+			if(record.start.x < 0 || record.start.y < 0 || record.start.x >= sizeX || record.start.y >= sizeY || end.x < 0 || end.y < 0 || end.x >= sizeX || end.y >= sizeY) return file_badFormat;
+			if(recordCells.size() + record.length > shipCells) return file_badFormat;		//More record cells than ship cells, so some overlap or are off ships
+			int hits = 0;
+			for(int n = 0; n < record.length; n++)
+			{
+				const int x = record.start.x + step.x * n;
+				const int y = record.start.y + step.y * n;
+				const uint32_t w = uint32_t(x / bitBoard_type::bitsPerWord);
+				if(((savedWord(bitBoard_type::shipPlane, w, y) >> (x % bitBoard_type::bitsPerWord)) & 1) == 0) return file_badFormat;
+				hits += int((savedWord(bitBoard_type::hitPlane, w, y) >> (x % bitBoard_type::bitsPerWord)) & 1);
+				recordCells.push_back((uint64_t(y) << 32) | uint32_t(x));
+			}
+			if(hits != record.hits) return file_badFormat;
+		}
+		if(shipCount > 0)
+		{
+			if(recordCells.size() != shipCells) return file_badFormat;		//Ship cells no record covers
+			std::sort(recordCells.begin(), recordCells.end());
+			if(std::adjacent_find(recordCells.begin(), recordCells.end()) != recordCells.end()) return file_badFormat;		//Two records on the same cell
+		}
+
+		//The data is good, so replace the board with it
+		size = coordi(sizeX, sizeY);
+		board.resize(size);
+		view = coordi(0, 0);
+
+		if(savedVersion == binaryLevel::tiledVersion)
+		{
+			const char * tile = planes + 4;
+			for(uint32_t i = 0; i < tileCount; i++, tile += binaryLevel::tileSize)
+			{
+				const int tileX = int(binaryLevel::get32(tile));
+				const int tileY = int(binaryLevel::get32(tile + 4));
+				for(int plane = 0; plane < bitBoard_type::planeCount; plane++)
+				{
+					for(int row = 0; row < bitBoard_type::tileRows && tileY * bitBoard_type::tileRows + row < sizeY; row++)
+					{
+						const uint64_t word = binaryLevel::get64(tile + 8 + (plane * bitBoard_type::tileRows + row) * sizeof(uint64_t));
+						board.setWord(bitBoard_type::plane_type(plane), tileX, tileY * bitBoard_type::tileRows + row, word);
+					}
+				}
+			}
+		}
+		else if(board.isSparse())	//Whole planes, but too big to keep whole (only the words with something in them are stored)
+		{
+			const char * word = planes;
+			for(int plane = 0; plane < bitBoard_type::planeCount; plane++)
+			{
+				for(int y = 0; y < sizeY; y++)
+				{
+					for(uint32_t w = 0; w < rowWords; w++, word += sizeof(uint64_t))
+					{
+						board.setWord(bitBoard_type::plane_type(plane), int(w), y, binaryLevel::get64(word));
+					}
+				}
+			}
+		}
+		else if(binaryLevel::isLittleEndian()) std::memcpy(board.data(), planes, size_t(planeBytes));
+		else
+		{
+			for(size_t i = 0; i < board.wordCount(); i++)
+			{
+				board.data()[i] = binaryLevel::get64(planes + i * sizeof(uint64_t));
+			}
+		}
+
+		ships.swap(loadedShips);
+		shipIndexStale = true;
+		forgetHistory();
+		shots = savedShots;
+		shotsMax = savedShotsMax;
+		lastSunkShip = -1;
+		fileErrors.clear();
+		shipProblems.clear();
+		if(ships.empty()) identifyShips();		//Levels converted from text by older versions only have cells
+		recountShips();
+		rehash();
+		return noerror;
+	}
+
+	errorstates saveToBinary(string filename)		//Saves the board to 'filename' in the binary level format.  Returns file_writeFailed if the file can't be written
+	{
+		string data;
+		saveToMemory(data);
+
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), std::streamsize(data.size()));
+		return (file ? noerror : file_writeFailed);
+	}
+
+	errorstates saveToText(string filename)		//Saves the board to 'filename' in the text level format (the same format loadFromFile() reads).  Ship records, hits left and shots are not kept.  Returns file_writeFailed if the file can't be written
+	{
+		string data;
+		data.reserve(size_t(size.x) * 2 * size.y);
+
+		for(int y = 0; y < size.y; y++)
+		{
+			for(int x = 0; x < size.x; x++)
+			{
+				data += utilities::toChar(board.getCell(x, y), true);
+				data += (x == size.x - 1 ? '\n' : ' ');
+			}
+		}
+
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), std::streamsize(data.size()));
+		return (file ? noerror : file_writeFailed);
+	}
+
+	const vector<errorstates> & getFileErrors() { return fileErrors; }	//The errors encountered (and recovered from) when the last file was loaded
+	const vector<shipProblem_type> & getShipProblems() { return shipProblems; }	//What was wrong with how the ships were laid out in the last file loaded
+
+	bool printErrors(std::ostream & out)		//Prints any errors encoutered when loading the file to 'out'.  Returns false if there weren't any
+	{
+		if(fileErrors.size() > 0 || shipProblems.size() > 0)
+		{
+			out << "The following errors were encountered when loading the file, but were recovered from:" << endl;
+			for(auto iter = fileErrors.begin(); iter != fileErrors.end(); iter++)
+			{
+				out << utilities::errorStateToString(*iter) << endl;
+			}
+			for(auto iter = shipProblems.begin(); iter != shipProblems.end(); iter++)
+			{
+				out << utilities::errorStateToString(iter->error) << " (at " << util::columnName(iter->at.x) << iter->at.y << ")" << endl;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void print(screenBuffer_type & screen, bool showHiddenShips = false)	//Prints the part of the game board on the screen to 'screen', with its coordinates, as well as the shots remaining
+	{
+		profiling::scopedTimer_type timer(profiling::phase_print);
+		const int labelWidth = rowLabelWidth();
+		const int viewWidth = viewColumns();
+		coordi displacement = coordi(labelWidth + 1, 2);		//The coordinates of the upper left portion of the board on the buffer
+
+		//Only the cells in view are drawn, so a huge board costs no more than a small one.  Cells past the edge of a small board are left blank
+		const int columns = std::min(size.x - view.x, viewWidth);
+		const int rows = std::min(size.y - view.y, viewRows);
+
+		renderedRow.assign(size_t(frameRight), ' ');
+		for(int y = 0; y < viewRows; y++)
+		{
+			if(y < rows) board.renderRow(view.y + y, view.x, columns, showHiddenShips, &renderedRow[0]);
+			else std::fill(renderedRow.begin(), renderedRow.end(), ' ');
+			screen.writeSpan(coordi(0, y) + displacement, &renderedRow[0], frameRight - displacement.x, true);		//Up to the right edge of the frame, whatever was drawn there before
+		}
+
+		//The left edge of the frame, where the row numbers end.  The top and bottom edges are redrawn up to the board's title in case it has moved
+		for(int x = 0; x < 21; x++)
+		{
+			const char edge = (x < labelWidth ? ' ' : char(205));
+			screen.write(coordi(x, 1), (x == labelWidth ? char(201) : edge));
+			screen.write(coordi(x, 27), (x == labelWidth ? char(200) : edge));
+		}
+		for(int y = 0; y < viewRows; y++) screen.write(coordi(labelWidth, displacement.y + y), char(186));
+
+		//The coordinates along the edges: the name of every column along the top (of every other or third column once the names are too long to fit over each
+		//one), and the number of each row down the side
+		const int nameLength = int(util::columnName(size.x - 1).size());
+		const int every = (nameLength + 2) / 2;		//Leaves at least one space between names
+		std::fill(renderedRow.begin(), renderedRow.end(), ' ');
+		for(int x = 0; x < columns; x++)
+		{
+			if((view.x + x) % every != 0) continue;
+			const string name = util::columnName(view.x + x);
+			for(int i = 0; i < int(name.size()) && displacement.x + 2 * x + i < frameRight; i++)
+			{
+				renderedRow[displacement.x + 2 * x + i] = name[i];
+			}
+		}
+		screen.writeSpan(coordi(0, 0), &renderedRow[0], frameRight, true);
+
+		for(int y = 0; y < viewRows; y++)
+		{
+			char number[16];
+			if(y < rows) snprintf(number, sizeof(number), "%-*d", labelWidth, view.y + y);
+			else snprintf(number, sizeof(number), "%*s", labelWidth, "");
+			screen.writeSpan(coordi(0, displacement.y + y), number, labelWidth, true);
+		}
+
+		//Prints the shots remaining
+		char shotsText[16];
+		const int length = snprintf(shotsText, sizeof(shotsText), "%-5d", getShots());		//Padded to clear what was there before
+		screen.writeSpan(coordi(54 + 2, 2 + 15), shotsText, length, true);
+
+		//Where the screen is on a board that doesn't fit on it, and how to move it (blank for boards that do fit)
+		char status[4][32] = {};
+		if(isScrollable())
+		{
+			snprintf(status[0], sizeof(status[0]), "Top left: %s%d", util::columnName(view.x).c_str(), view.y);
+			snprintf(status[1], sizeof(status[1]), "   of %dx%d", size.x, size.y);
+			snprintf(status[2], sizeof(status[2]), "view <coordinate>");
+			snprintf(status[3], sizeof(status[3]), "scroll <direction> [n]");
+		}
+		for(int i = 0; i < 4; i++)
+		{
+			char line[32];
+			const int lineLength = snprintf(line, sizeof(line), "%-23s", status[i]);		//Padded to the edge of the screen
+			screen.writeSpan(coordi(54, 2 + 17 + i + (i >= 2 ? 1 : 0)), line, lineLength, true);
+		}
+	}
+
+	void destroyAllShips()		//Marks every ship on the board as hit (used by the #killall debug command)
+	{
+		//Every ship cell that hasn't been hit yet and every ship's hits go in the history first, so this can be undone too
+		board.forEachWord(bitBoard_type::shipPlane, 0, size.y, [&](int w, int y, uint64_t shipWord)
+		{
+			for(uint64_t live = shipWord & ~board.getWord(bitBoard_type::hitPlane, w, y); live != 0; live &= live - 1)
+			{
+				const int x = w * bitBoard_type::bitsPerWord + util::countTrailingZeros(live);
+				recordChange(coordi(x, y), ship);
+				toggleKeys(x, y, zobrist::planeBits(ship) ^ zobrist::planeBits(destroyed_ship));		//Each of them is about to become a destroyed ship
+			}
+		});
+		for(int i = 0; i < int(ships.size()); i++)
+		{
+			if(ships[i].hits != ships[i].length) recordChange(coordi(-1, -1), ocean, i);
+		}
+
+		board.destroyAllShips();
+
+		for(auto iter = ships.begin(); iter != ships.end(); iter++)
+		{
+			iter->hits = iter->length;
+		}
+		liveShipCells = 0;
+
+		if(journal != nullptr) journal->recordAllShipsDestroyed();
+	}
+
+	static const vector<int> & defaultFleet()		//The lengths of the ships generateGameBoard() places
+	{
+		static const vector<int> lengths {2, 2, 3, 3, 4};
+		return lengths;
+	}
+
+	bool generateGameBoard()		//Randomly generates a game board to play on.  Returns false if the fleet could not be fit onto the board
+	{
+		return placeFleet(defaultFleet());
+	}
+
+};
+
+errorstates convertLevel(string from, string to)		//Converts the level in 'from' to the other format (text -> binary, binary -> text), and saves it in 'to'
+{	//A text level has no header, so its size is taken from the file: the number of lines, and the most cells on any line.  Returns the first error from loading or saving
+	mappedFile_type file(from);
+	if(!file.isOpen()) return file_notFound;
+
+	if(binaryLevel::isBinaryLevel(file.data(), file.size()))
+	{
+		gameBoard_type level(coordi(1, 1));
+		errorstates error = level.loadFromBinary(file.data(), file.size());
+		return (error != noerror ? error : level.saveToText(to));
+	}
+
+	coordi size(0, 0);
+	int cells = 0;
+	for(size_t i = 0; i <= file.size(); i++)
+	{
+		if(i == file.size() || file.data()[i] == '\n')
+		{
+			if(cells > 0 || (i < file.size() && size.y == 0)) size.y++;
+			size.x = std::max(size.x, cells);
+			cells = 0;
+		}
+		else if(file.data()[i] != ' ' && file.data()[i] != '\r') cells++;
+	}
+	if(size.x < 1 || size.y < 1) return file_badSize;
+
+	gameBoard_type level(size);
+	size_t offset = 0;
+	level.loadFromMemory(file.data(), file.size(), offset);
+	return level.saveToBinary(to);
+}
+
+errorstates loadLevelPack(string filename, coordi levelSize, vector<gameBoard_type> & levels)	//Loads every level in a level pack into 'levels': levels of 'levelSize' stored one after another in one file, optionally with blank lines between them
+{	//Returns file_notFound if the file can't be opened.  The errors recovered from in each level are in that level's getFileErrors()
+	mappedFile_type file(filename);
+	if(!file.isOpen()) return file_notFound;
+
+	levels.clear();
+	size_t offset = 0;
+
+	while(true)
+	{
+		//Skip the blank lines between levels
+		size_t next = offset;
+		while(next < file.size() && (file.data()[next] == ' ' || file.data()[next] == '\r' || file.data()[next] == '\n'))
+		{
+			if(file.data()[next] == '\n') offset = next + 1;
+			next++;
+		}
+		if(next >= file.size()) break;
+
+		levels.push_back(gameBoard_type(levelSize));
+		levels.back().loadFromMemory(file.data(), file.size(), offset);
+	}
+
+	return noerror;
+}
+
+class journalReader_type		//Reads a game journal (see journal_type): finds the games and boards in it, and rebuilds the board as it was after any turn of any game
+{	//The file is memory mapped, and the records are all the same size, so finding the boards is one pass over the file that only reads one byte of most records
+	struct boardIndex_type		//A board record in the journal, and the shots after it up to the next board record
+	{
+		size_t offset;
+		int game;
+		int turn;
+		int endTurn;		//The turn of the last shot before the next board record ('turn' if there are none)
+	};
+
+	mappedFile_type file;
+	vector<boardIndex_type> boards;		//In the order they're in the file, so also ordered by game.  Within a game the turns go back after an undo
+	vector<int> gameTurns;				//The turn each game ended on: the number of shots recorded, less any that were undone
+	errorstates error = noerror;
+
+	errorstates index()
+	{
+		if(!file.isOpen()) return file_notFound;
+
+		const char * data = file.data();
+		const size_t length = file.size();
+		if(length < gameJournal::headerSize || std::memcmp(data, gameJournal::magic, 4) != 0) return file_badFormat;
+		if(binaryLevel::get16(data + 4) != gameJournal::version || binaryLevel::get16(data + 6) != gameJournal::recordSize) return file_badVersion;
+
+		size_t offset = gameJournal::headerSize;
+		while(offset + gameJournal::recordSize <= length)	//A record cut off at the end (the program stopped while writing it) is ignored
+		{
+			const int event = uint8_t(data[offset]);
+			size_t next = offset + gameJournal::recordSize;
+
+			if(event >= gameJournal::eventCount) return file_badFormat;
+
+			if(event == gameJournal::newBoard || event == gameJournal::checkpoint)
+			{
+				next += gameJournal::paddedSize(binaryLevel::get32(data + offset + 4));
+				if(next > length) break;
+
+				if(event == gameJournal::newBoard) gameTurns.push_back(0);
+				if(!gameTurns.empty())
+				{
+					const int turn = int(binaryLevel::get32(data + offset + 12));
+					boards.push_back({ offset, int(gameTurns.size()) - 1, turn, turn });
+					gameTurns.back() = turn;		//Earlier than the last shot if this is the board after an undo
+				}
+			}
+			else if(event == gameJournal::shot && !gameTurns.empty())
+			{
+				gameTurns.back() = int(binaryLevel::get32(data + offset + 12));
+				boards.back().endTurn = gameTurns.back();
+			}
+
+			offset = next;
+		}
+		return noerror;
+	}
+
+public:
+	journalReader_type(string filename) : file(filename) { error = index(); }
+
+	errorstates getError() { return error; }		//Why the journal couldn't be read, or noerror
+	int getGameCount() { return int(gameTurns.size()); }
+	int getTurnCount(int game) { return gameTurns[game]; }
+
+	//Sets 'board' to how it was right after shot 'turn' (0 = before the first shot) of 'game' (from 0).  If shots were undone, and the game came back to the turn more than
+	//once, it is set to how it was the last time.  Starts from the last board recorded before that, and replays the events after it.  Returns the turn reached, which is
+	//less than 'turn' if the game has fewer shots (the board is then as the game ended).  Fails with board_badX if there is no such game, or with the error loading the
+	//board if the journal is damaged.
+	outcome_type<int> seek(int game, int turn, gameBoard_type & board)
+	{
+		if(error != noerror) return error;
+		if(game < 0 || game >= getGameCount()) return board_badX;
+		turn = std::max(turn, 0);
+
+		//The last board whose shots reach the turn, or the game's last board if none do
+		auto first = std::lower_bound(boards.begin(), boards.end(), game, [](const boardIndex_type & entry, int target) { return entry.game < target; });
+		auto last = std::upper_bound(first, boards.end(), game, [](int target, const boardIndex_type & entry) { return target < entry.game; });
+		auto found = last - 1;		//Every game starts with a board, so there is at least one
+		while(found != first && !(found->turn <= turn && turn <= found->endTurn)) found--;
+		if(!(found->turn <= turn && turn <= found->endTurn)) found = last - 1;
+		const boardIndex_type & start = *found;
+
+		const char * data = file.data();
+		const size_t length = file.size();
+
+		journal_type * journal = board.getJournal();		//Replaying isn't something to record
+		board.setJournal(nullptr);
+
+		const size_t levelLength = binaryLevel::get32(data + start.offset + 4);
+		errorstates loaded = board.loadFromBinary(data + start.offset + gameJournal::recordSize, levelLength);
+		if(loaded != noerror)
+		{
+			board.setJournal(journal);
+			return loaded;
+		}
+
+		int reached = start.turn;
+		size_t offset = start.offset + gameJournal::recordSize + gameJournal::paddedSize(levelLength);
+		while(offset + gameJournal::recordSize <= length)
+		{
+			const char * record = data + offset;
+			const int event = uint8_t(record[0]);
+			offset += gameJournal::recordSize;
+
+			if(event == gameJournal::newBoard || event == gameJournal::checkpoint) break;		//The next game, or the next board of this one (which starts where this one's shots end)
+
+			switch(event)
+			{
+				case gameJournal::shot:
+				{
+					const int shotTurn = int(binaryLevel::get32(record + 12));
+					if(shotTurn > turn)
+					{
+						offset = length;	//Done
+						break;
+					}
+					board.fire(coordi(int(binaryLevel::get32(record + 4)), int(binaryLevel::get32(record + 8))));
+					reached = shotTurn;
+				}
+					break;
+
+				case gameJournal::shotsSet:
+					board.setShots(int(binaryLevel::get32(record + 12)), true);
+					break;
+
+				case gameJournal::allShipsDestroyed:
+					board.destroyAllShips();
+					break;
+			}
+		}
+
+		board.setJournal(journal);
+		return reached;
+	}
+};
+
+struct shotRecord_type		//A shot fired in a gameSession_type, and what it did
+{
+	coordi at;
+	shotResult result;
+	int sunkLength;		//The length of the ship the shot sank, or 0 if it didn't sink one
+};
+
+class gameSession_type		//One game: a board, the shots fired at it, and whether the game has been won or lost.  Doesn't use the console or any globals,
+{							//so games can be played from code as fast as the CPU allows, and many sessions can run at once (one per thread, or many on one thread)
+	gameBoard_type board;
+	gameState_type state = title;	//'title' until a game is started, then 'running', 'win' or 'lose'
+	random_type random;				//The session's own generator, so sessions don't share (or fight over) one
+	vector<shotRecord_type> shots;	//Every shot fired this game, in order
+
+	void refillShots()		//Gives the board a full set of shots for the next game.  Not journaled: the journal gets them with the new board, and recording them here would
+	{						//put them at the end of the last game instead
+		journal_type * journal = board.getJournal();
+		board.setJournal(nullptr);
+		board.setShots(board.getMaxShots());
+		board.setJournal(journal);
+	}
+
+public:
+	gameSession_type(coordi boardSize = coordi(25, 25), uint64_t seed = 0) : board(boardSize), random(seed) {}
+
+	bool newGame(const vector<int> & fleet = gameBoard_type::defaultFleet())	//Starts a new game on a randomly generated board.  Returns false if the fleet doesn't fit on the board
+	{
+		shots.clear();
+		refillShots();
+
+		if(!board.placeFleet(fleet, random))
+		{
+			state = title;
+			return false;
+		}
+
+		state = running;
+		return true;
+	}
+
+	errorstates loadGame(string filename)		//Starts a new game on a board loaded from 'filename'.  Returns the error if the file can't be loaded; problems that were recovered from are in getBoard().getFileErrors()
+	{
+		shots.clear();
+		refillShots();
+		board.emptyBoard();
+
+		errorstates error = board.loadFromFile(filename);
+		state = (error == noerror ? board.checkWinLoss() : title);
+		return error;
+	}
+
+	void newGame(const gameBoard_type & level)		//Starts a new game on a copy of 'level' (with the shots it has left), so a level only has to be loaded once to be played many times
+	{
+		journal_type * journal = board.getJournal();	//The session's journal, not whatever 'level' was recorded in
+
+		shots.clear();
+		board = level;
+		board.setJournal(journal, true);
+		state = board.checkWinLoss();
+	}
+
+	void updateState()		//Checks for a win or loss again, needed after the board has been changed by something other than fire() (i.e. setting the shots remaining)
+	{
+		if(state == running) state = board.checkWinLoss();
+	}
+
+	void reseed(uint64_t seed) { random.setSeed(seed); }
+
+	outcome_type<shotResult> fire(coordi at)		//Fires at 'at'.  Returns board_badX/board_badY (and records nothing) if 'at' isn't on the board
+	{
+		if(state != running) return noAmmo;
+
+		outcome_type<shotResult> result = board.fire(at);
+		if(!result.ok()) return result;
+
+		shotRecord_type record;
+		record.at = at;
+		record.result = result.value;
+
+		const shipRecord_type * sunk = board.getLastSunkShip();
+		record.sunkLength = (sunk != nullptr ? sunk->length : 0);
+
+		shots.push_back(record);
+		state = board.checkWinLoss();
+		return record.result;
+	}
+
+	gameState_type getState() { return state; }
+	gameBoard_type & getBoard() { return board; }
+	const vector<shotRecord_type> & getShotLog() { return shots; }
+};
+
+//Randomly places 'fleet' on every board in 'boards', spread over 'threadCount' threads (0 = one per core).  Returns the number of boards the fleet could not be placed on.
+//Board i is generated from its own generator, seeded from 'seed' and i, so the same seed always gives the same boards no matter how many threads are used.
+int generateBoards(vector<gameBoard_type> & boards, const vector<int> & fleet, uint64_t seed, int threadCount = 0)
+{
+	if(threadCount <= 0) threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+	threadCount = std::min(threadCount, std::max(1, int(boards.size())));
+
+	std::atomic<int> failures(0);
+
+	auto worker = [&](size_t first, size_t last)
+	{
+		random_type random;		//This worker's generator
+		int workerFailures = 0;
+
+		for(size_t i = first; i < last; i++)
+		{
+			uint64_t boardSeed = seed ^ (0xD1B54A32D192ED03ULL * (i + 1));
+			random.setSeed(util::splitMix64(boardSeed));
+
+			if(!boards[i].placeFleet(fleet, random)) workerFailures++;
+		}
+		failures += workerFailures;
+	};
+
+	vector<std::thread> threads;
+	const size_t perThread = (boards.size() + threadCount - 1) / threadCount;
+	for(int t = 1; t < threadCount; t++)
+	{
+		threads.push_back(std::thread(worker, std::min(boards.size(), t * perThread), std::min(boards.size(), (t + 1) * perThread)));
+	}
+	worker(0, std::min(boards.size(), perThread));	//The calling thread takes the first share
+
+	for(auto iter = threads.begin(); iter != threads.end(); iter++)
+	{
+		iter->join();
+	}
+
+	return failures;
+}
+
+class shooter_type		//A computer player.  Decides where to fire next, and is told what every shot did
+{
+public:
+	virtual ~shooter_type() {}
+
+	virtual string getName() = 0;
+	virtual void newGame(coordi boardSize, const vector<int> & fleet, uint64_t seed) = 0;	//Forgets the last game, and gets ready to fire at a new board
+	virtual coordi nextShot() = 0;															//Returns where to fire next.  Never returns a cell that has already been fired at
+	virtual void recordShot(coordi at, shotResult result, int sunkLength) = 0;				//Tells the shooter what the shot at 'at' did.  'sunkLength' is the length of the ship sunk, or 0
+};
+
+class randomShooter_type : public shooter_type		//Fires at every cell once, in a random order
+{
+	vector<coordi> order;
+	int next = 0;
+	random_type random;
+
+public:
+	string getName() { return "random"; }
+
+	void newGame(coordi boardSize, const vector<int> &, uint64_t seed)
+	{
+		random.setSeed(seed);
+		order.clear();
+		for(int y = 0; y < boardSize.y; y++)
+		{
+			for(int x = 0; x < boardSize.x; x++)
+			{
+				order.push_back(coordi(x, y));
+			}
+		}
+
+		for(int i = int(order.size()) - 1; i > 0; i--)		//Fisher-Yates shuffle
+		{
+			std::swap(order[i], order[random.range(0, i)]);
+		}
+		next = 0;
+	}
+
+	coordi nextShot() { return order[next++]; }
+	void recordShot(coordi, shotResult, int) {}
+};
+
+class huntTargetShooter_type : public shooter_type		//Fires at random on a checkerboard pattern (hunting) until it hits something, then works through the cells next to the hits (targeting)
+{
+	coordi size;
+	vector<bool> fired;
+	vector<coordi> huntOrder;	//Cells to hunt in, the checkerboard cells first (every ship covers at least one of them)
+	int nextHunt = 0;
+	vector<coordi> targets;		//Cells next to hits, still to be fired at
+	random_type random;
+
+	bool isUnfired(coordi pos) { return 0 <= pos.x && pos.x < size.x && 0 <= pos.y && pos.y < size.y && !fired[pos.y * size.x + pos.x]; }
+
+public:
+	string getName() { return "hunt/target"; }
+
+	void newGame(coordi boardSize, const vector<int> &, uint64_t seed)
+	{
+		size = boardSize;
+		random.setSeed(seed);
+		fired.assign(size.x * size.y, false);
+		targets.clear();
+
+		huntOrder.clear();
+		for(int parity = 0; parity < 2; parity++)
+		{
+			const size_t first = huntOrder.size();
+			for(int y = 0; y < size.y; y++)
+			{
+				for(int x = 0; x < size.x; x++)
+				{
+					if((x + y) % 2 == parity) huntOrder.push_back(coordi(x, y));
+				}
+			}
+			for(size_t i = huntOrder.size() - 1; i > first; i--)	//Shuffle within each half
+			{
+				std::swap(huntOrder[i], huntOrder[first + random.below(i - first + 1)]);
+			}
+		}
+		nextHunt = 0;
+	}
+
+	coordi nextShot()
+	{
+		while(!targets.empty())
+		{
+			coordi target = targets.back();
+			targets.pop_back();
+			if(isUnfired(target)) return target;
+		}
+
+		while(!isUnfired(huntOrder[nextHunt])) nextHunt++;
+		return huntOrder[nextHunt++];
+	}
+
+	void recordShot(coordi at, shotResult result, int sunkLength)
+	{
+		fired[at.y * size.x + at.x] = true;
+
+		if(result == hit && sunkLength == 0)	//Once the ship is sunk there's no point looking around it any more
+		{
+			for(int dir = 0; dir < 4; dir++)
+			{
+				coordi step = util::toStep(direction_type(dir));
+				coordi next(at.x + step.x, at.y + step.y);
+				if(isUnfired(next)) targets.push_back(next);
+			}
+		}
+	}
+};
+
+class densityShooter_type : public shooter_type		//Fires at the cell the most placements of the remaining ships could cover
+{	//Per ship length it keeps, for every cell, how many placements of that length cover the cell without touching a miss or a sunk ship, and the total of
+	//those counts weighted by how many ships of each length are left.  The counts only change near the cell just fired at, so they are updated
+	//incrementally (O(length^2) per shot) instead of being recounted.  Picking the best cell is then two flat passes over int arrays, which the compiler vectorizes.
+	enum cellState_type { unknown, missed, hitCell, sunkCell };
+
+	coordi size;
+	int area = 0;
+	vector<uint8_t> state;			//A cellState_type per cell
+	vector<int> unfired;			//1 for cells not fired at yet, 0 for the rest (an int so it can be multiplied into the scores)
+	vector<int> lengths;			//The different ship lengths in the fleet
+	vector<int> remaining;			//How many ships of each of 'lengths' haven't been sunk
+	vector<vector<int>> coverage;	//coverage[i][cell] = number of valid placements of a ship of lengths[i] covering 'cell'
+	vector<int> density;			//density[cell] = the sum of coverage[i][cell] * remaining[i]
+	vector<int> score;
+	vector<int> unsunkHits;			//Cells that were hit, but aren't known to belong to a sunk ship yet
+
+	int cellIndex(int x, int y) { return y * size.x + x; }
+	bool isBlocked(int index) { return state[index] == missed || state[index] == sunkCell; }	//No ship can be placed over a blocked cell
+
+	//Calls 'action(first, step)' for every placement of a ship of 'length' that covers (x, y), where 'first' is the placement's first cell and 'step' is the index difference between its cells
+	template <typename action_type> void forEachPlacement(int x, int y, int length, action_type action)
+	{
+		for(int startX = std::max(0, x - length + 1); startX <= std::min(x, size.x - length); startX++)
+		{
+			action(cellIndex(startX, y), 1);
+		}
+		if(length > 1)	//A ship of length 1 is the same placement either way, so only count it once
+		{
+			for(int startY = std::max(0, y - length + 1); startY <= std::min(y, size.y - length); startY++)
+			{
+				action(cellIndex(x, startY), size.x);
+			}
+		}
+	}
+
+	void block(int x, int y)	//Marks (x, y) as somewhere no ship can be, and removes the placements that covered it from the coverage counts
+	{
+		const int index = cellIndex(x, y);
+		if(isBlocked(index)) return;
+
+		for(size_t i = 0; i < lengths.size(); i++)
+		{
+			const int length = lengths[i];
+			vector<int> & counts = coverage[i];
+
+			forEachPlacement(x, y, length, [&](int first, int step)
+			{
+				for(int k = 0; k < length; k++)		//If the placement was already blocked by another cell, it was already removed
+				{
+					if(isBlocked(first + k * step)) return;
+				}
+				for(int k = 0; k < length; k++)
+				{
+					counts[first + k * step]--;
+					density[first + k * step] -= remaining[i];
+				}
+			});
+		}
+	}
+
+	void markSunk(int x, int y, int length)		//Works out which hits belong to the ship of 'length' that was just sunk at (x, y).  Only acts if there's exactly one possibility
+	{
+		int candidates = 0;
+		int candidateFirst = 0;
+		int candidateStep = 0;
+
+		forEachPlacement(x, y, length, [&](int first, int step)
+		{
+			for(int k = 0; k < length; k++)
+			{
+				if(state[first + k * step] != hitCell) return;
+			}
+			candidates++;
+			candidateFirst = first;
+			candidateStep = step;
+		});
+
+		if(candidates != 1) return;		//Ambiguous, leave the hits as they are and let targeting sort it out
+
+		for(int k = 0; k < length; k++)
+		{
+			const int index = candidateFirst + k * candidateStep;
+			block(index % size.x, index / size.x);
+			state[index] = sunkCell;
+			unsunkHits.erase(std::find(unsunkHits.begin(), unsunkHits.end(), index));
+		}
+	}
+
+	bool scoreTargets()		//Scores the cells around unsunk hits by how many valid placements cover them and the hits.  Returns false if there's nothing to target
+	{
+		std::fill(score.begin(), score.end(), 0);
+		bool found = false;
+
+		for(size_t h = 0; h < unsunkHits.size(); h++)
+		{
+			const int hitX = unsunkHits[h] % size.x;
+			const int hitY = unsunkHits[h] / size.x;
+
+			for(size_t i = 0; i < lengths.size(); i++)
+			{
+				if(remaining[i] == 0) continue;
+				const int length = lengths[i];
+
+				forEachPlacement(hitX, hitY, length, [&](int first, int step)
+				{
+					int hitsCovered = 0;
+					for(int k = 0; k < length; k++)
+					{
+						const int index = first + k * step;
+						if(isBlocked(index)) return;
+						if(state[index] == hitCell) hitsCovered++;
+					}
+
+					//Placements covering more of the hits are much more likely to be the real ship
+					const int weight = remaining[i] * hitsCovered * hitsCovered;
+					for(int k = 0; k < length; k++)
+					{
+						score[first + k * step] += weight * unfired[first + k * step];
+					}
+					found = true;
+				});
+			}
+		}
+		return found;
+	}
+
+	void rebuildDensity()		//Recomputes 'density' from the coverage counts, needed whenever the number of ships remaining changes
+	{
+		int * total = &density[0];
+		for(int c = 0; c < area; c++) total[c] = 0;
+
+		for(size_t i = 0; i < lengths.size(); i++)
+		{
+			const int weight = remaining[i];
+			const int * counts = &coverage[i][0];
+			for(int c = 0; c < area; c++)
+			{
+				total[c] += weight * counts[c];
+			}
+		}
+	}
+
+	void scoreDensity()		//Scores every unfired cell by how many placements of the remaining ships could cover it, fired cells score 0
+	{
+		int * scores = &score[0];
+		const int * total = &density[0];
+		const int * open = &unfired[0];
+
+		for(int c = 0; c < area; c++)
+		{
+			scores[c] = (total[c] + 1) * open[c];		//The + 1 keeps unfired cells above fired ones even when nothing can fit there
+		}
+	}
+
+	int bestScore()		//Returns the index of the first cell with the highest score
+	{
+		const int * scores = &score[0];
+
+		int best = 0;
+		for(int c = 0; c < area; c++)	//A plain max reduction vectorizes, an argmax with a branch in it doesn't
+		{
+			best = std::max(best, scores[c]);
+		}
+		return int(std::find(score.begin(), score.end(), best) - score.begin());
+	}
+
+public:
+	string getName() { return "probability density"; }
+
+	void newGame(coordi boardSize, const vector<int> & fleet, uint64_t)
+	{
+		size = boardSize;
+		area = size.x * size.y;
+		state.assign(area, unknown);
+		unfired.assign(area, 1);
+		score.assign(area, 0);
+		density.assign(area, 0);
+		unsunkHits.clear();
+
+		lengths.clear();
+		remaining.clear();
+		for(auto iter = fleet.begin(); iter != fleet.end(); iter++)
+		{
+			auto found = std::find(lengths.begin(), lengths.end(), *iter);
+			if(found == lengths.end())
+			{
+				lengths.push_back(*iter);
+				remaining.push_back(1);
+			}
+			else remaining[found - lengths.begin()]++;
+		}
+
+		//Nothing is blocked yet, so every placement that fits on the board counts
+		coverage.assign(lengths.size(), vector<int>(area, 0));
+		for(size_t i = 0; i < lengths.size(); i++)
+		{
+			const int length = lengths[i];
+			for(int y = 0; y < size.y; y++)
+			{
+				for(int x = 0; x < size.x; x++)
+				{
+					if(x + length <= size.x)
+					{
+						for(int k = 0; k < length; k++) coverage[i][cellIndex(x + k, y)]++;
+					}
+					if(length > 1 && y + length <= size.y)
+					{
+						for(int k = 0; k < length; k++) coverage[i][cellIndex(x, y + k)]++;
+					}
+				}
+			}
+		}
+		rebuildDensity();
+	}
+
+	coordi nextShot()
+	{
+		if(unsunkHits.empty() || !scoreTargets()) scoreDensity();
+
+		int best = bestScore();
+		if(!unfired[best])	//Only happens when targeting found placements but all of their cells have been fired at
+		{
+			best = int(std::find(unfired.begin(), unfired.end(), 1) - unfired.begin());
+		}
+		return coordi(best % size.x, best / size.x);
+	}
+
+	void recordShot(coordi at, shotResult result, int sunkLength)
+	{
+		const int index = cellIndex(at.x, at.y);
+		if(!unfired[index]) return;
+		unfired[index] = 0;
+
+		if(result == hit)
+		{
+			state[index] = hitCell;
+			unsunkHits.push_back(index);
+
+			if(sunkLength > 0)
+			{
+				auto found = std::find(lengths.begin(), lengths.end(), sunkLength);
+				if(found != lengths.end() && remaining[found - lengths.begin()] > 0) remaining[found - lengths.begin()]--;
+				rebuildDensity();
+				markSunk(at.x, at.y, sunkLength);
+			}
+		}
+		else
+		{
+			block(at.x, at.y);
+			state[index] = missed;
+		}
+	}
+};
+
+class posteriorSolver_type		//Counts every placement of the fleet that agrees with what a player has seen of a board, and from that the exact chance of each cell holding a ship
+{	//(with every such placement equally likely).  The cells are swept row by row, and the state between two cells is how much of a vertical ship is still to come in each
+	//column, how much of the current horizontal ship is left, and which ships haven't been placed yet.  Counting the ways to reach every state going forwards, and the ways to
+	//finish from it going backwards, gives the number of placements covering each cell without listing a single placement.  Large steps are split across threads.
+	//A player only hears the length of each ship sunk, not which hits it was made of, so a ship lying wholly on hits is taken from the sunk ships and any other ship from
+	//those still afloat; that way the ships lying wholly on hits are exactly the ones that have been sunk.  Positions with too many states for that (i.e. several ships
+	//afloat on a 25x25 board) can be estimated from random placements instead, with estimate().
+public:
+	enum seen_type		//What is known about a cell
+	{
+		seen_unknown,	//Not fired at
+		seen_miss,		//Fired at, nothing there
+		seen_hit		//Hit, so some ship has to cover it
+	};
+
+	struct result_type
+	{
+		uint64_t placements = 0;		//The number of placements of the fleet that agree with what was seen.  0 if there are none
+		vector<double> probability;		//The chance each cell (row-major) holds one of the ships, 0 for every cell if there are no placements
+		bool estimated = false;			//True when these came from estimate() rather than solve()
+	};
+
+	static const int maxWidth = 37;			//The narrower side of the board is swept across, and every column takes 3 bits of a state
+	static const int maxLength = 8;			//So what is left of a ship fits in 3 bits
+	static const int maxFleetStates = 8192;	//The number of different sets of unplaced ships has to fit in the 13 bits the state has left
+	static const uint64_t maxCoverSteps = 1 << 20;	//The most steps estimate() takes finding the ways to cover the hits
+
+private:
+	struct entry_type		//A state (what is left of each vertical ship in 'low' and 'high', then the horizontal ship and the unplaced ships in the top of 'high') and its number of ways
+	{
+		uint64_t low;
+		uint64_t high;
+		uint64_t count;
+	};
+
+	static uint64_t hashOf(uint64_t low, uint64_t high)
+	{
+		uint64_t hash = (low ^ (high * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+		return hash ^ (hash >> 31);
+	}
+
+	class table_type		//A hash table from state to number of ways, with open addressing.  A count is never 0, so a 0 count marks an empty slot
+	{
+		vector<entry_type> slots;
+		size_t mask = 0;
+		size_t used = 0;
+
+		void grow()
+		{
+			vector<entry_type> old;
+			old.swap(slots);
+			reset(old.size());
+			for(size_t i = 0; i < old.size(); i++)
+			{
+				if(old[i].count != 0) add(old[i].low, old[i].high, old[i].count);
+			}
+		}
+
+	public:
+		bool overflow = false;		//Set if a count went past what 64 bits can hold
+
+		void reset(size_t expected)
+		{
+			size_t capacity = 64;
+			while(capacity < expected * 2) capacity *= 2;
+			slots.assign(capacity, entry_type { 0, 0, 0 });
+			mask = capacity - 1;
+			used = 0;
+		}
+
+		void add(uint64_t low, uint64_t high, uint64_t count)
+		{
+			if((used + 1) * 2 > slots.size()) grow();
+
+			size_t i = size_t(hashOf(low, high)) & mask;
+			while(slots[i].count != 0 && (slots[i].low != low || slots[i].high != high)) i = (i + 1) & mask;
+
+			if(slots[i].count == 0)
+			{
+				slots[i] = entry_type { low, high, count };
+				used++;
+				return;
+			}
+			slots[i].count += count;
+			if(slots[i].count < count) overflow = true;
+		}
+
+		uint64_t find(uint64_t low, uint64_t high) const		//Returns the state's count, 0 if it isn't in the table
+		{
+			size_t i = size_t(hashOf(low, high)) & mask;
+			while(slots[i].count != 0)
+			{
+				if(slots[i].low == low && slots[i].high == high) return slots[i].count;
+				i = (i + 1) & mask;
+			}
+			return 0;
+		}
+
+		size_t size() const { return used; }
+
+		void collect(vector<entry_type> & into) const		//Appends every state in the table to 'into'
+		{
+			for(size_t i = 0; i < slots.size(); i++)
+			{
+				if(slots[i].count != 0) into.push_back(slots[i]);
+			}
+		}
+	};
+
+	struct shardedTable_type		//Several tables, each holding the states whose hash picks it, so each can be filled by its own thread
+	{
+		vector<table_type> shards;
+
+		size_t shardOf(uint64_t low, uint64_t high) const { return size_t(hashOf(low, high) >> 40) % shards.size(); }
+		uint64_t find(uint64_t low, uint64_t high) const { return shards[shardOf(low, high)].find(low, high); }
+	};
+
+	static const int horizontalShift = 48;		//Where the rest of the horizontal ship is kept in 'high'
+	static const int fleetShift = 51;			//Where the index of the set of unplaced ships is kept in 'high'
+	static const size_t statesPerThread = 16384;	//Steps with fewer states than this per thread aren't worth splitting up
+
+	int width = 0;
+	int height = 0;
+	bool transposed = false;		//True when the board was swept column by column (as if it was turned on its side), because it is narrower that way
+	vector<uint8_t> seen;			//A seen_type per cell, in sweep order
+	vector<uint8_t> runRight;		//The number of cells from each cell to the right that a ship could cover, including the cell
+	vector<uint8_t> runDown;		//The same, downwards
+	vector<uint8_t> hitRight;		//The number of hits in a row from each cell to the right, including the cell
+	vector<uint8_t> hitDown;		//The same, downwards
+	vector<int> lengths;			//The different ship lengths, once among the sunk ships and once among those afloat
+	vector<bool> sunkKind;			//Whether lengths[i] is one of the sunk ships, which lie wholly on hits, or one of those afloat, which don't
+	vector<int> radix;				//The unplaced ships are a mixed-radix number, one digit (how many are unplaced) per entry in 'lengths'
+	vector<uint8_t> unplaced;		//unplaced[fleetIndex * lengths.size() + i] = how many ships of lengths[i] are unplaced in that set
+	int threadCount = 1;
+	bool overflow = false;
+	table_type stepTable;			//Kept between steps, so single threaded steps don't allocate a new table every time
+
+	//Calls 'emit(low, high, occupied)' for every state sweeping over 'cell' can lead to from the state (low, high).  'occupied' is true when a ship covers the cell
+	template <typename emit_type> void forEachNext(uint64_t low, uint64_t high, int cell, emit_type & emit) const
+	{
+		const int x = cell % width;
+		const int shift = (x < 21 ? 3 * x : 3 * (x - 21));
+		uint64_t & word = (x < 21 ? low : high);
+		const int vertical = int((word >> shift) & 7);
+		const int horizontal = int((high >> horizontalShift) & 7);
+
+		if(vertical > 0 || horizontal > 0)		//A ship already started covers this cell (ships only start where they have room, so it isn't blocked)
+		{
+			if(vertical > 0 && horizontal > 0) return;		//Two ships would cross here
+			if(vertical > 0) word -= uint64_t(1) << shift;
+			else high -= uint64_t(1) << horizontalShift;
+			emit(low, high, true);
+			return;
+		}
+
+		if(seen[cell] != seen_hit) emit(low, high, false);	//Left empty, unless it's a hit
+		if(runRight[cell] == 0) return;						//Nothing can start on a blocked cell
+
+		const int fleetIndex = int(high >> fleetShift);
+		for(size_t i = 0; i < lengths.size(); i++)
+		{
+			if(unplaced[fleetIndex * lengths.size() + i] == 0) continue;
+
+			const int length = lengths[i];
+			const uint64_t placed = high - (uint64_t(radix[i]) << fleetShift);
+			if(runRight[cell] >= length && (hitRight[cell] >= length) == sunkKind[i]) emit(low, placed + (uint64_t(length - 1) << horizontalShift), true);
+			if(length > 1 && runDown[cell] >= length && (hitDown[cell] >= length) == sunkKind[i])		//A ship of length 1 is the same placement either way, so only count it once
+			{
+				uint64_t verticalLow = low;
+				uint64_t verticalHigh = placed;
+				(x < 21 ? verticalLow : verticalHigh) += uint64_t(length - 1) << shift;
+				emit(verticalLow, verticalHigh, true);
+			}
+		}
+	}
+
+	template <typename work_type> void inParallel(size_t count, int threads, work_type work)	//Calls work(first, last, thread) for 'threads' even shares of [0, count)
+	{
+		if(threads <= 1)
+		{
+			work(size_t(0), count, 0);
+			return;
+		}
+
+		vector<std::thread> workers;
+		const size_t perThread = (count + threads - 1) / threads;
+		for(int t = 1; t < threads; t++)
+		{
+			workers.push_back(std::thread(work, std::min(count, t * perThread), std::min(count, (t + 1) * perThread), t));
+		}
+		work(size_t(0), std::min(count, perThread), 0);		//The calling thread takes the first share
+
+		for(auto iter = workers.begin(); iter != workers.end(); iter++)
+		{
+			iter->join();
+		}
+	}
+
+	int threadsFor(size_t states) { return int(std::max<size_t>(1, std::min<size_t>(size_t(threadCount), states / statesPerThread))); }
+
+	void step(const vector<entry_type> & from, int cell, vector<entry_type> & to)		//Sweeps over 'cell': 'to' gets every state reachable from the states in 'from', with their numbers of ways
+	{
+		const int threads = threadsFor(from.size());
+		to.clear();
+
+		if(threads == 1)
+		{
+			table_type & table = stepTable;
+			table.reset(from.size() * 2);
+			for(size_t i = 0; i < from.size(); i++)
+			{
+				const uint64_t count = from[i].count;
+				auto emit = [&](uint64_t low, uint64_t high, bool) { table.add(low, high, count); };
+				forEachNext(from[i].low, from[i].high, cell, emit);
+			}
+			table.collect(to);
+			if(table.overflow) overflow = true;
+			return;
+		}
+
+		vector<vector<table_type>> partial(threads, vector<table_type>(threads));		//partial[thread][shard]
+		vector<vector<entry_type>> merged(threads);
+
+		inParallel(from.size(), threads, [&](size_t first, size_t last, int thread)
+		{
+			vector<table_type> & tables = partial[thread];
+			for(int s = 0; s < threads; s++) tables[s].reset((last - first) * 2 / threads);
+
+			for(size_t i = first; i < last; i++)
+			{
+				const uint64_t count = from[i].count;
+				auto emit = [&](uint64_t low, uint64_t high, bool) { tables[size_t(hashOf(low, high) >> 40) % threads].add(low, high, count); };
+				forEachNext(from[i].low, from[i].high, cell, emit);
+			}
+		});
+
+		inParallel(size_t(threads), threads, [&](size_t shard, size_t, int)
+		{
+			table_type table;
+			table.reset(partial[0][shard].size() * threads);
+			for(int t = 0; t < threads; t++)
+			{
+				vector<entry_type> entries;
+				partial[t][shard].collect(entries);
+				for(size_t i = 0; i < entries.size(); i++) table.add(entries[i].low, entries[i].high, entries[i].count);
+				if(partial[t][shard].overflow) table.overflow = true;
+			}
+			table.collect(merged[shard]);
+			if(table.overflow) partial[0][shard].overflow = true;
+		});
+
+		for(int t = 0; t < threads; t++)
+		{
+			to.insert(to.end(), merged[t].begin(), merged[t].end());
+			if(partial[0][t].overflow) overflow = true;
+		}
+	}
+
+	//Works backwards over 'cell': 'finishing' holds the ways to finish from every state after the cell, and is replaced by the ways to finish from every state in 'before'
+	//(the states before the cell).  Returns the number of placements with a ship on the cell.
+	uint64_t stepBack(const vector<entry_type> & before, int cell, shardedTable_type & finishing)
+	{
+		const int threads = threadsFor(before.size());
+
+		if(threads == 1 && finishing.shards.size() == 1)
+		{
+			table_type & previous = stepTable;
+			previous.reset(before.size());
+
+			uint64_t covered = 0;
+			for(size_t i = 0; i < before.size(); i++)
+			{
+				uint64_t ways = 0;
+				uint64_t waysOccupied = 0;
+				auto emit = [&](uint64_t low, uint64_t high, bool occupied)
+				{
+					const uint64_t next = finishing.shards[0].find(low, high);
+					ways += next;
+					if(occupied) waysOccupied += next;
+				};
+				forEachNext(before[i].low, before[i].high, cell, emit);
+
+				covered += before[i].count * waysOccupied;		//Never more than the total, so this can't overflow if the total didn't
+				if(ways != 0) previous.add(before[i].low, before[i].high, ways);
+			}
+			std::swap(finishing.shards[0], previous);
+			return covered;
+		}
+
+		vector<vector<entry_type>> finishes(threads);
+		vector<uint64_t> covered(threads, 0);
+
+		inParallel(before.size(), threads, [&](size_t first, size_t last, int thread)
+		{
+			for(size_t i = first; i < last; i++)
+			{
+				uint64_t ways = 0;
+				uint64_t waysOccupied = 0;
+				auto emit = [&](uint64_t low, uint64_t high, bool occupied)
+				{
+					const uint64_t next = finishing.find(low, high);
+					ways += next;
+					if(occupied) waysOccupied += next;
+				};
+				forEachNext(before[i].low, before[i].high, cell, emit);
+
+				covered[thread] += before[i].count * waysOccupied;		//Never more than the total, so this can't overflow if the total didn't
+				if(ways != 0) finishes[thread].push_back(entry_type { before[i].low, before[i].high, ways });
+			}
+		});
+
+		shardedTable_type previous;
+		previous.shards.resize(threads);
+		inParallel(size_t(threads), threads, [&](size_t shard, size_t, int)
+		{
+			table_type & table = previous.shards[shard];
+			table.reset(before.size() / threads);
+			for(int t = 0; t < threads; t++)
+			{
+				for(size_t i = 0; i < finishes[t].size(); i++)
+				{
+					const entry_type & entry = finishes[t][i];
+					if(previous.shardOf(entry.low, entry.high) == shard) table.add(entry.low, entry.high, entry.count);
+				}
+			}
+		});
+		finishing.shards.swap(previous.shards);
+
+		uint64_t total = 0;
+		for(int t = 0; t < threads; t++) total += covered[t];
+		return total;
+	}
+
+	//Fills 'lengths' and 'sunkKind' with the kinds of ship (each length once among the sunk ships and once among those afloat), and 'counts' with how many ships there are
+	//of each kind.  Returns false if more ships of a length have been sunk than there are in the fleet
+	bool groupShips(const vector<int> & fleet, const vector<int> & sunk, vector<int> & counts)
+	{
+		lengths.clear();
+		sunkKind.clear();
+		counts.clear();
+		auto addShip = [&](int length, bool isSunk, int count)		//Adds 'count' ships of 'length' to the sunk ships or those afloat.  Returns false if there are fewer than none
+		{
+			for(size_t i = 0; i < lengths.size(); i++)
+			{
+				if(lengths[i] == length && sunkKind[i] == isSunk) return (counts[i] += count) >= 0;
+			}
+			lengths.push_back(length);
+			sunkKind.push_back(isSunk);
+			counts.push_back(count);
+			return count >= 0;
+		};
+		for(auto iter = fleet.begin(); iter != fleet.end(); iter++)
+		{
+			addShip(*iter, false, 1);
+		}
+		for(auto iter = sunk.begin(); iter != sunk.end(); iter++)
+		{
+			if(!addShip(*iter, false, -1)) return false;
+			addShip(*iter, true, 1);
+		}
+		return true;
+	}
+
+public:
+	//Solves the board of 'size' with 'cells' (a seen_type per cell, row-major) for the ships in 'fleet', of which those with the lengths in 'sunk' have been sunk.  Uses
+	//every core if 'threads' is 0.  Returns solver_tooLarge if the board, a ship or the fleet is too big for the state to hold, the number of placements doesn't fit in
+	//64 bits, or the sweep goes through more than 'limit' states in all (0 for no limit), which bounds the time a solve can take
+	errorstates solve(coordi size, const vector<uint8_t> & cells, const vector<int> & fleet, const vector<int> & sunk, result_type & result, uint64_t limit = 0, int threads = 0)
+	{
+		result.placements = 0;
+		result.probability.assign(size_t(size.x) * size.y, 0.0);
+
+		transposed = (size.y < size.x);
+		width = (transposed ? size.y : size.x);
+		height = (transposed ? size.x : size.y);
+		if(width > maxWidth) return solver_tooLarge;
+
+		threadCount = (threads > 0 ? threads : std::max(1, int(std::thread::hardware_concurrency())));
+		overflow = false;
+
+		const int area = width * height;
+		seen.assign(area, seen_unknown);
+		for(int y = 0; y < height; y++)
+		{
+			for(int x = 0; x < width; x++)
+			{
+				seen[y * width + x] = (transposed ? cells[x * size.x + y] : cells[y * size.x + x]);
+			}
+		}
+
+		runRight.assign(area, 0);
+		runDown.assign(area, 0);
+		hitRight.assign(area, 0);
+		hitDown.assign(area, 0);
+		for(int cell = area - 1; cell >= 0; cell--)
+		{
+			if(seen[cell] == seen_miss) continue;
+			const int x = cell % width;
+			runRight[cell] = uint8_t(std::min(maxLength, 1 + (x + 1 < width ? runRight[cell + 1] : 0)));
+			runDown[cell] = uint8_t(std::min(maxLength, 1 + (cell + width < area ? runDown[cell + width] : 0)));
+			if(seen[cell] != seen_hit) continue;
+			hitRight[cell] = uint8_t(std::min(maxLength, 1 + (x + 1 < width ? hitRight[cell + 1] : 0)));
+			hitDown[cell] = uint8_t(std::min(maxLength, 1 + (cell + width < area ? hitDown[cell + width] : 0)));
+		}
+
+		for(auto iter = fleet.begin(); iter != fleet.end(); iter++)
+		{
+			if(*iter < 1 || *iter > maxLength) return solver_tooLarge;
+		}
+		vector<int> counts;
+		if(!groupShips(fleet, sunk, counts)) return noerror;		//More ships of a length sunk than there are in the fleet: nothing agrees with that
+
+		int fleetStates = 1;
+		radix.assign(lengths.size(), 0);
+		for(size_t i = 0; i < lengths.size(); i++)
+		{
+			radix[i] = fleetStates;
+			fleetStates *= counts[i] + 1;
+			if(fleetStates > maxFleetStates) return solver_tooLarge;
+		}
+		unplaced.assign(size_t(fleetStates) * lengths.size(), 0);
+		for(int index = 0; index < fleetStates; index++)
+		{
+			for(size_t i = 0; i < lengths.size(); i++)
+			{
+				unplaced[index * lengths.size() + i] = uint8_t((index / radix[i]) % (counts[i] + 1));
+			}
+		}
+
+		//Forwards: the ways to reach every state.  Only the states at the start of each row are kept; the rest are worked out again on the way back
+		vector<vector<entry_type>> rowStarts(height);
+		rowStarts[0].push_back(entry_type { 0, uint64_t(fleetStates - 1) << fleetShift, 1 });		//Nothing placed yet: every digit at its highest
+
+		vector<entry_type> current = rowStarts[0];
+		vector<entry_type> next;
+		uint64_t placements = 0;
+		uint64_t states = 0;
+		for(int cell = 0; cell < area; cell++)
+		{
+			step(current, cell, next);
+			current.swap(next);
+			states += current.size();
+			if(limit != 0 && states > limit) return solver_tooLarge;
+			if((cell + 1) % width == 0 && cell + 1 < area) rowStarts[(cell + 1) / width] = current;
+		}
+		for(size_t i = 0; i < current.size(); i++)
+		{
+			if(current[i].low == 0 && current[i].high == 0) placements = current[i].count;		//Everything placed and finished
+		}
+		if(overflow) return solver_tooLarge;
+
+		result.placements = placements;
+		if(placements == 0) return noerror;
+
+		//Backwards: the ways to finish from every state, and with them the placements covering each cell
+		shardedTable_type finishing;
+		finishing.shards.resize(1);
+		finishing.shards[0].reset(1);
+		finishing.shards[0].add(0, 0, 1);
+
+		vector<vector<entry_type>> row(width);
+		for(int y = height - 1; y >= 0; y--)
+		{
+			row[0] = rowStarts[y];
+			for(int x = 1; x < width; x++) step(row[x - 1], y * width + x - 1, row[x]);
+			rowStarts[y].clear();
+			rowStarts[y].shrink_to_fit();
+
+			for(int x = width - 1; x >= 0; x--)
+			{
+				const uint64_t covered = stepBack(row[x], y * width + x, finishing);
+				const int original = (transposed ? x * size.x + y : y * size.x + x);
+				result.probability[original] = double(covered) / double(placements);
+			}
+		}
+
+		return noerror;
+	}
+
+	//Estimates what solve() counts exactly, for positions with too many states to sweep (i.e. several ships still afloat).  Every way to cover the hits is found first,
+	//by giving the first hit not yet covered each ship and placement that could cover it in turn; as a player only hears about sunk ships, there are seldom more than a
+	//few.  For each of those, 'samples' (shared out between them) random placements of the ships left are made on the cells that haven't been fired at, one ship at a
+	//time in one of the places it fits.  A placement is weighted by the number of places each ship had (over the orders the ships of a kind could have been put down
+	//in), which makes the weighted placements an unbiased estimate of the number of placements and of the number covering each cell.  The last ship isn't put down:
+	//every place it fits gets an even share of the placement instead, which takes out the noise of that one pick, and makes positions with one ship left exact.  The
+	//weights are kept relative to the largest seen so far, so they can't overflow however many ships there are.  Returns solver_tooLarge if there are more than
+	//maxCoverSteps steps to finding the ways to cover the hits
+	errorstates estimate(coordi size, const vector<uint8_t> & cells, const vector<int> & fleet, const vector<int> & sunk, result_type & result, int samples, random_type & random)
+	{
+		const int area = size.x * size.y;
+		result.placements = 0;
+		result.probability.assign(area, 0.0);
+		result.estimated = true;
+
+		for(auto iter = fleet.begin(); iter != fleet.end(); iter++)
+		{
+			if(*iter < 1) return solver_tooLarge;
+		}
+		vector<int> counts;
+		if(!groupShips(fleet, sunk, counts)) return noerror;
+
+		vector<int> hits;
+		vector<uint8_t> taken(area);		//Misses, and cells a ship has been put on
+		for(int i = 0; i < area; i++)
+		{
+			if(cells[i] == seen_hit) hits.push_back(i);
+			taken[i] = (cells[i] == seen_miss);
+		}
+
+		struct option_type
+		{
+			int kind;		//The index in 'lengths'
+			int start;		//The cell of its top or left end
+			int step;		//1 for a ship running right, size.x for one running down
+		};
+		vector<option_type> placed;
+		vector<int> left = counts;			//How many ships of each kind haven't been put down
+		int shipsLeft = int(fleet.size());
+		int hitsLeft = int(hits.size());	//Hits no ship has been put on yet
+
+		auto fits = [&](int kind, int start, int step)		//Whether the ship of kind 'kind' can lie from 'start' along 'step' (which must keep it on the board)
+		{
+			bool allHits = true;
+			for(int k = 0, cell = start; k < lengths[kind]; k++, cell += step)
+			{
+				if(taken[cell]) return false;
+				if(cells[cell] != seen_hit) allHits = false;
+			}
+			return allHits == sunkKind[kind];
+		};
+		auto place = [&](const option_type & option)
+		{
+			for(int k = 0, cell = option.start; k < lengths[option.kind]; k++, cell += option.step)
+			{
+				taken[cell] = 1;
+				hitsLeft -= (cells[cell] == seen_hit);
+			}
+			left[option.kind]--;
+			shipsLeft--;
+			placed.push_back(option);
+		};
+		auto takeBack = [&]()		//Undoes the last place()
+		{
+			const option_type option = placed.back();
+			for(int k = 0, cell = option.start; k < lengths[option.kind]; k++, cell += option.step)
+			{
+				taken[cell] = 0;
+				hitsLeft += (cells[cell] == seen_hit);
+			}
+			left[option.kind]++;
+			shipsLeft++;
+			placed.pop_back();
+		};
+
+		double total = 0;
+		vector<double> covering(area, 0.0);
+		double scale = 0;		//The log of the weight 'total' and 'covering' are counted in units of
+		bool anyWeight = false;
+		vector<double> lastShip(area);		//How many of the places the last ship fits cover each cell
+		vector<int> runRight(area);			//The free cells from each cell rightwards, up to the length of the ship being put down
+		vector<int> runDown(area);
+
+		auto count = [&](double logWeight, uint64_t lastFitting)		//Counts the ships in 'placed', and the last ship spread over its 'lastFitting' places if that isn't 0
+		{
+			if(!anyWeight || logWeight > scale)		//Counts everything so far in units of the new largest weight
+			{
+				const double shrink = (anyWeight ? std::exp(scale - logWeight) : 0.0);
+				total *= shrink;
+				for(int i = 0; i < area; i++) covering[i] *= shrink;
+				scale = logWeight;
+				anyWeight = true;
+			}
+			const double weight = std::exp(logWeight - scale);
+			total += weight;
+			for(auto iter = placed.begin(); iter != placed.end(); iter++)
+			{
+				for(int k = 0, cell = iter->start; k < lengths[iter->kind]; k++, cell += iter->step) covering[cell] += weight;
+			}
+			if(lastFitting > 0)
+			{
+				const double share = weight / double(lastFitting);
+				for(int i = 0; i < area; i++) covering[i] += share * lastShip[i];
+			}
+		};
+
+		vector<uint8_t> coveredTaken;
+		vector<int> coveredLeft;
+		auto placeRest = [&](int draws)		//Makes 'draws' random placements of the ships left once the hits are covered, each weighted 1 / 'draws'
+		{
+			coveredTaken = taken;
+			coveredLeft = left;
+			const size_t coveredShips = placed.size();
+			const int coveredShipsLeft = shipsLeft;
+
+			for(int draw = 0; draw < draws; draw++)
+			{
+				double logWeight = -std::log(double(draws));
+				uint64_t lastFitting = 0;
+				bool stuck = false;
+				for(int kind = 0; kind < int(lengths.size()) && !stuck; kind++)
+				{
+					const int length = lengths[kind];
+					for(int order = 1; left[kind] > 0; order++)
+					{
+						uint64_t fitting = 0;
+						for(int cell = area - 1; cell >= 0; cell--)
+						{
+							const int x = cell % size.x;
+							runRight[cell] = (taken[cell] ? 0 : std::min(length, 1 + (x + 1 < size.x ? runRight[cell + 1] : 0)));
+							runDown[cell] = (taken[cell] ? 0 : std::min(length, 1 + (cell + size.x < area ? runDown[cell + size.x] : 0)));
+							fitting += (runRight[cell] == length) + (length > 1 && runDown[cell] == length);
+						}
+						if(fitting == 0)
+						{
+							stuck = true;
+							break;
+						}
+						logWeight += std::log(double(fitting) / order);		//The ships of a kind could have been put down in any order
+
+						if(shipsLeft == 1)
+						{
+							std::fill(lastShip.begin(), lastShip.end(), 0.0);
+							for(int cell = 0; cell < area; cell++)
+							{
+								if(runRight[cell] == length) for(int k = 0; k < length; k++) lastShip[cell + k] += 1;
+								if(length > 1 && runDown[cell] == length) for(int k = 0; k < length; k++) lastShip[cell + k * size.x] += 1;
+							}
+							lastFitting = fitting;
+							left[kind]--;
+							shipsLeft--;
+							break;
+						}
+
+						uint64_t pick = random.below(fitting);
+						for(int cell = 0; cell < area; cell++)
+						{
+							if(runRight[cell] == length && pick-- == 0)
+							{
+								place(option_type { kind, cell, 1 });
+								break;
+							}
+							if(length > 1 && runDown[cell] == length && pick-- == 0)
+							{
+								place(option_type { kind, cell, size.x });
+								break;
+							}
+						}
+					}
+				}
+				if(!stuck) count(logWeight, lastFitting);
+
+				taken = coveredTaken;
+				left = coveredLeft;
+				placed.resize(coveredShips);
+				shipsLeft = coveredShipsLeft;
+			}
+		};
+
+		//Finds every way to cover the hits, twice: once to count them, and again to place the rest of the fleet around each of them
+		bool counting = true;
+		int coverings = 0;
+		uint64_t steps = 0;
+		auto cover = [&](auto & self, size_t next) -> void
+		{
+			if(++steps > maxCoverSteps) return;
+			while(next < hits.size() && taken[hits[next]]) next++;
+
+			int room = 0;			//How many hits the ships left could cover
+			int sunkCells = 0;		//How many hits the sunk ships left have to lie on
+			for(size_t kind = 0; kind < lengths.size(); kind++)
+			{
+				room += left[kind] * lengths[kind];
+				if(sunkKind[kind]) sunkCells += left[kind] * lengths[kind];
+			}
+			if(room < hitsLeft || sunkCells > hitsLeft) return;
+
+			if(next == hits.size())
+			{
+				if(counting) coverings++;
+				else placeRest(shipsLeft <= 1 ? 1 : std::max(1, samples / coverings));		//One ship left is spread over every place it fits, so one draw is exact
+				return;
+			}
+
+			const int hit = hits[next];
+			const int hx = hit % size.x;
+			const int hy = hit / size.x;
+			for(int kind = 0; kind < int(lengths.size()); kind++)
+			{
+				if(left[kind] == 0) continue;
+				const int length = lengths[kind];
+				for(int k = 0; k < length; k++)
+				{
+					if(hx - k >= 0 && hx - k + length <= size.x && fits(kind, hit - k, 1))
+					{
+						place(option_type { kind, hit - k, 1 });
+						self(self, next + 1);
+						takeBack();
+					}
+					if(length > 1 && hy - k >= 0 && hy - k + length <= size.y && fits(kind, hit - k * size.x, size.x))
+					{
+						place(option_type { kind, hit - k * size.x, size.x });
+						self(self, next + 1);
+						takeBack();
+					}
+				}
+			}
+		};
+		cover(cover, 0);
+		if(steps > maxCoverSteps) return solver_tooLarge;
+		if(coverings == 0) return noerror;
+
+		counting = false;
+		cover(cover, 0);
+
+		if(!anyWeight) return noerror;
+		const double placements = std::exp(scale) * total;
+		result.placements = (placements >= 1.8e19 ? UINT64_MAX : std::max<uint64_t>(1, uint64_t(placements + 0.5)));
+		for(int i = 0; i < area; i++)
+		{
+			result.probability[i] = covering[i] / total;
+		}
+		return noerror;
+	}
+
+	//Fills in what a player would know about 'board': where the misses and hits are, the lengths of the ships in the fleet, and the lengths of those that have been sunk
+	//(but not which hits they were made of).  Boards without ship records (i.e. text levels) have no fleet
+	static void observe(gameBoard_type & board, vector<uint8_t> & cells, vector<int> & fleet, vector<int> & sunk)
+	{
+		const coordi size = board.getBoardSize();
+		cells.assign(size_t(size.x) * size.y, seen_unknown);
+		fleet.clear();
+		sunk.clear();
+
+		for(int y = 0; y < size.y; y++)
+		{
+			for(int x = 0; x < size.x; x++)
+			{
+				const cellContents_type contents = board.getContentsUnchecked(coordi(x, y));
+				if(contents == shot_miss) cells[y * size.x + x] = seen_miss;
+				else if(contents == destroyed_ship) cells[y * size.x + x] = seen_hit;
+			}
+		}
+
+		const vector<shipRecord_type> & ships = board.getShips();
+		for(size_t i = 0; i < ships.size(); i++)
+		{
+			fleet.push_back(ships[i].length);
+			if(ships[i].isSunk()) sunk.push_back(ships[i].length);
+		}
+	}
+};
+
+struct solveSummary_type		//What #solve found for a board: the number of placements, and the unfired cell most likely to hold a ship
+{
+	uint64_t placements;
+	int best;				//The cell (row-major), or -1 if there are no placements
+	double probability;		//The chance it holds a ship
+	bool estimated;			//True when the board had too many states to solve exactly, so these are estimates
+};
+
+transpositionCache_type<solveSummary_type> solveCache(1 << 12);		//#solve's answers by board hash, so solving a position seen before (i.e. after an undo) is a lookup
+const uint64_t solveStateLimit = 1 << 20;		//The most states #solve lets the solver go through (about a quarter of a second) before it estimates instead.  Enough for two ships afloat on a 25x25 board
+const int solveSamples = 10000;					//The random placements #solve's estimates are made from, about a quarter of a second with five ships afloat on a 25x25 board
+
+std::unique_ptr<shooter_type> makeShooter(string name)		//Creates the shooter called 'name' ("random", "hunt" or "density").  Returns nullptr for any other name
+{
+	if(name == "random") return std::unique_ptr<shooter_type>(new randomShooter_type());
+	if(name == "hunt") return std::unique_ptr<shooter_type>(new huntTargetShooter_type());
+	if(name == "density") return std::unique_ptr<shooter_type>(new densityShooter_type());
+	return nullptr;
+}
+
+struct shooterBatchResult_type		//The results of a shooter playing a batch of games
+{
+	string name;
+	int games = 0;
+	double seconds = 0;
+	vector<int> shotsToWin;		//shotsToWin[n] = the number of games won in exactly n shots
+	int shotsMax = 0;			//The shot budget a real game has
+	int winsWithinMax = 0;		//The number of games that were won within 'shotsMax' shots
+	int unplaced = 0;			//Boards the fleet couldn't be placed on, which aren't played or counted in 'games'
+
+	void start(const string & shooterName, coordi boardSize, int maxShots)		//Empties the results, ready for 'shooterName' to play games on boards of 'boardSize'
+	{
+		name = shooterName;
+		games = 0;
+		seconds = 0;
+		shotsToWin.assign(boardSize.x * boardSize.y + 1, 0);
+		shotsMax = maxShots;
+		winsWithinMax = 0;
+		unplaced = 0;
+	}
+
+	void addGame(int shots)		//Counts a game that was won in 'shots' shots, or a board the fleet couldn't be placed on if 'shots' is -1
+	{
+		if(shots < 0)
+		{
+			unplaced++;
+			return;
+		}
+		games++;
+		shotsToWin[shots]++;
+		if(shots <= shotsMax) winsWithinMax++;
+	}
+
+	void merge(const shooterBatchResult_type & other)		//Adds the games in 'other', which must have been played by the same shooter on the same size of board
+	{
+		games += other.games;
+		seconds += other.seconds;
+		for(size_t n = 0; n < shotsToWin.size(); n++) shotsToWin[n] += other.shotsToWin[n];
+		winsWithinMax += other.winsWithinMax;
+		unplaced += other.unplaced;
+	}
+
+	double meanShots() const
+	{
+		double total = 0;
+		for(size_t n = 0; n < shotsToWin.size(); n++) total += double(n) * shotsToWin[n];
+		return games > 0 ? total / games : 0;
+	}
+
+	int percentile(double fraction) const		//Returns the number of shots 'fraction' of the games were won within
+	{
+		int seen = 0;
+		for(size_t n = 0; n < shotsToWin.size(); n++)
+		{
+			seen += shotsToWin[n];
+			if(seen >= fraction * games) return int(n);
+		}
+		return int(shotsToWin.size()) - 1;
+	}
+
+	void print(std::ostream & out)
+	{
+		out << name << ": " << games << " games, " << std::fixed << games / seconds << " games/sec" << endl;
+		out << "   shots to win: mean " << meanShots() << ", p10 " << percentile(0.1) << ", p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", max " << percentile(1.0) << endl;
+		out << "   won within " << shotsMax << " shots: " << (games > 0 ? 100.0 * winsWithinMax / games : 0) << "%" << endl;
+		if(unplaced > 0) out << "   " << unplaced << " boards skipped, as the fleet couldn't be placed on them" << endl;
+	}
+};
+
+//Has 'shooter' play the board generated from 'seed' in 'session' until it wins.  The game is played with unlimited shots, so that it always ends in a win and the full
+//shots-to-win distribution can be collected.  Returns the number of shots it took, or -1 if the fleet couldn't be placed on the board (so there was no game)
+int playShooterGame(shooter_type & shooter, gameSession_type & session, uint64_t seed, const vector<int> & fleet)
+{
+	const coordi boardSize = session.getBoard().getBoardSize();
+	session.reseed(seed);
+	if(!session.newGame(fleet)) return -1;
+	session.getBoard().setShots(boardSize.x * boardSize.y);
+	shooter.newGame(boardSize, fleet, seed);
+
+	int shots = 0;
+	while(session.getState() == running)
+	{
+		coordi at = shooter.nextShot();
+		shotResult shot = session.fire(at).value;		//Shooters only ever fire at cells on the board
+		shooter.recordShot(at, shot, session.getShotLog().back().sunkLength);
+		shots++;
+	}
+	return shots;
+}
+
+//Has 'shooter' play 'games' games on randomly generated boards (game i is generated from 'seed' + i), and counts how many would have been won under the normal shot limit
+shooterBatchResult_type runShooterBatch(shooter_type & shooter, int games, uint64_t seed, coordi boardSize = coordi(25, 25), const vector<int> & fleet = gameBoard_type::defaultFleet())
+{
+	gameSession_type session(boardSize);
+
+	shooterBatchResult_type result;
+	result.start(shooter.getName(), boardSize, session.getBoard().getMaxShots());
+
+	auto start = std::chrono::steady_clock::now();
+	for(int game = 0; game < games; game++)
+	{
+		result.addGame(playShooterGame(shooter, session, seed + game, fleet));
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return result;
+}
+
+//Runs a batch of tasks on a set of threads.  Each thread has its own queue, which it works through from the back; a thread whose queue has run dry steals from the
+//front of the other threads' queues, so threads that drew quick tasks take work off the ones that drew slow ones.  Each queue has its own lock, which is only
+//contended while a thread is being stolen from
+template<typename task_type> class workStealingPool_type
+{
+	struct alignas(64) queue_type		//Kept on cache lines of their own, so threads working through their own queues don't slow each other down
+	{
+		std::mutex lock;
+		std::deque<task_type> tasks;
+	};
+
+	vector<queue_type> queues;		//One per thread
+	size_t nextQueue = 0;			//The queue add() puts the next task in
+	std::atomic<long long> steals;
+
+	bool take(int thread, task_type & task)		//Takes the next task for 'thread', from its own queue if it can.  Returns false if every queue is empty
+	{
+		{
+			queue_type & own = queues[thread];
+			std::lock_guard<std::mutex> hold(own.lock);
+			if(!own.tasks.empty())
+			{
+				task = own.tasks.back();
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+
+		for(size_t i = 1; i < queues.size(); i++)
+		{
+			queue_type & victim = queues[(thread + i) % queues.size()];
+			std::lock_guard<std::mutex> hold(victim.lock);
+			if(!victim.tasks.empty())
+			{
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				steals++;
+				return true;
+			}
+		}
+		return false;		//Tasks are only added before run(), so once every queue is empty they stay that way
+	}
+
+public:
+	workStealingPool_type(int threadCount = 0) : queues(threadCount > 0 ? threadCount : std::max(1, int(std::thread::hardware_concurrency()))), steals(0) {}		//0 threads = one per core
+
+	int getThreadCount() { return int(queues.size()); }
+	long long getSteals() { return steals; }		//The number of tasks run by a thread other than the one they were queued for
+
+	void add(const task_type & task)		//Queues 'task' for run().  Tasks are dealt out to the threads' queues in turn
+	{
+		queues[nextQueue].tasks.push_back(task);
+		nextQueue = (nextQueue + 1) % queues.size();
+	}
+
+	template<typename work_type> void run(work_type work)		//Calls work(task, thread) for every queued task, where 'thread' is the index of the thread running it.  Returns once they are all done
+	{
+		auto worker = [&](int thread)
+		{
+			task_type task;
+			while(take(thread, task)) work(task, thread);
+		};
+
+		vector<std::thread> threads;
+		for(int t = 1; t < getThreadCount(); t++)
+		{
+			threads.push_back(std::thread(worker, t));
+		}
+		worker(0);		//The calling thread is thread 0
+
+		for(auto iter = threads.begin(); iter != threads.end(); iter++)
+		{
+			iter->join();
+		}
+	}
+};
+
+struct tournamentResult_type		//The results of a tournament between shooters
+{
+	vector<shooterBatchResult_type> shooters;	//Best first.  'seconds' is the time the threads spent on each shooter's games, added up
+	int boards = 0;
+	int threads = 0;
+	long long steals = 0;		//Tasks that were stolen by another thread
+	double seconds = 0;
+
+	void print(std::ostream & out)
+	{
+		long long games = 0;
+		for(size_t i = 0; i < shooters.size(); i++) games += shooters[i].games;
+		out << "Tournament: " << shooters.size() << " shooters on " << boards << " boards, " << threads << " thread(s), " << std::fixed << games / seconds << " games/sec, " << steals << " tasks stolen" << endl;
+		if(!shooters.empty() && shooters[0].unplaced > 0) out << shooters[0].unplaced << " boards skipped, as the fleet couldn't be placed on them" << endl;		//The same boards for every shooter
+
+		char line[160];
+		for(size_t i = 0; i < shooters.size(); i++)
+		{
+			const shooterBatchResult_type & shooter = shooters[i];
+			snprintf(line, sizeof(line), "%2d. %-10s won within %d shots: %5.1f%%   mean shots to win: %6.1f   p90: %3d   %.3f ms/game", int(i + 1), shooter.name.c_str(), shooter.shotsMax,
+				(shooter.games > 0 ? 100.0 * shooter.winsWithinMax / shooter.games : 0), shooter.meanShots(), shooter.percentile(0.9), (shooter.games > 0 ? 1000 * shooter.seconds / shooter.games : 0));
+			out << line << endl;
+		}
+	}
+};
+
+//Has every shooter in 'names' (which makeShooter() must know) play the same 'boards' randomly generated boards, board i being generated from 'seed' + i as in runShooterBatch().
+//The games are scheduled on a work-stealing pool of 'threadCount' threads (0 = one per core), in tasks of up to 'gamesPerTask' games of one shooter.  Each thread counts its
+//games in results of its own, which are only merged once every game has been played, so the threads never write to shared counters and the results don't depend on the
+//number of threads.  The shooters are ranked by how many games they won within the shot limit, then by the mean shots they took to win
+tournamentResult_type runTournament(const vector<string> & names, int boards, uint64_t seed, int threadCount = 0, int gamesPerTask = 64, coordi boardSize = coordi(25, 25), const vector<int> & fleet = gameBoard_type::defaultFleet())
+{
+	struct task_type
+	{
+		int shooter;		//Index into 'names'
+		int firstBoard;
+		int endBoard;		//One past the last board
+	};
+
+	struct alignas(64) worker_type		//One thread's shooters, game and results, kept off the other threads' cache lines
+	{
+		vector<std::unique_ptr<shooter_type>> shooters;
+		std::unique_ptr<gameSession_type> session;
+		vector<shooterBatchResult_type> results;
+	};
+
+	workStealingPool_type<task_type> pool(threadCount);
+	for(int first = 0; first < boards; first += gamesPerTask)
+	{
+		for(int s = 0; s < int(names.size()); s++)
+		{
+			pool.add({ s, first, std::min(boards, first + gamesPerTask) });
+		}
+	}
+
+	vector<worker_type> workers(pool.getThreadCount());
+	for(auto iter = workers.begin(); iter != workers.end(); iter++)
+	{
+		iter->session.reset(new gameSession_type(boardSize));
+		iter->results.resize(names.size());
+		for(size_t s = 0; s < names.size(); s++)
+		{
+			iter->shooters.push_back(makeShooter(names[s]));
+			iter->results[s].start(names[s], boardSize, iter->session->getBoard().getMaxShots());
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	pool.run([&](const task_type & task, int thread)
+	{
+		worker_type & worker = workers[thread];
+		shooterBatchResult_type & result = worker.results[task.shooter];
+
+		auto taskStart = std::chrono::steady_clock::now();
+		for(int board = task.firstBoard; board < task.endBoard; board++)
+		{
+			result.addGame(playShooterGame(*worker.shooters[task.shooter], *worker.session, seed + board, fleet));
+		}
+		result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - taskStart).count();
+	});
+
+	tournamentResult_type tournament;
+	tournament.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	tournament.boards = boards;
+	tournament.threads = pool.getThreadCount();
+	tournament.steals = pool.getSteals();
+
+	tournament.shooters.swap(workers[0].results);
+	for(size_t t = 1; t < workers.size(); t++)
+	{
+		for(size_t s = 0; s < names.size(); s++)
+		{
+			tournament.shooters[s].merge(workers[t].results[s]);
+		}
+	}
+
+	std::stable_sort(tournament.shooters.begin(), tournament.shooters.end(), [](const shooterBatchResult_type & a, const shooterBatchResult_type & b)
+	{
+		if(a.winsWithinMax != b.winsWithinMax) return a.winsWithinMax > b.winsWithinMax;
+		return a.meanShots() < b.meanShots();
+	});
+	return tournament;
+}
+
+enum scriptAction_type		//The commands a command script can contain
+{
+	script_fire,		//fire <letter><number>
+	script_setShots,	//#setshots <number>
+	script_killAll,		//#killall
+};
+
+struct scriptCommand_type		//One command from a command script, already parsed
+{
+	scriptAction_type action;
+	coordi at;		//Where to fire, for script_fire
+	int value;		//The number of shots, for script_setShots
+};
+
+struct commandScript_type		//A command file, parsed once so it can be replayed against any number of games without being read again
+{
+	vector<scriptCommand_type> commands;
+	vector<int> badLines;		//The line numbers (from 1) of the lines that weren't understood, and were skipped
+};
+
+//Parses the commands in 'data' into 'script', one command per line, in the same form they are typed into the game.  Blank lines, lines starting with "//",
+//and #enable/#disable are skipped.  Debug commands don't have to be enabled first.
+void parseCommandScript(const char * data, size_t length, commandScript_type & script)
+{
+	script.commands.clear();
+	script.badLines.clear();
+
+	string line;		//The current line, lowercased (kept between lines so it doesn't have to be reallocated)
+	utilities::commandTokens_type command;
+	size_t offset = 0;
+
+	for(int lineNumber = 1; offset < length; lineNumber++)
+	{
+		const char * newline = (const char *) std::memchr(data + offset, '\n', length - offset);
+		const size_t lineLength = (newline != nullptr ? size_t(newline - (data + offset)) : length - offset);
+		line.assign(data + offset, lineLength);
+		offset += lineLength + 1;
+
+		if(!line.empty() && line.back() == '\r') line.pop_back();	//Windows line endings
+		utilities::toLowerInPlace(line);
+		utilities::tokenize(line, command);
+
+		if(command.size() == 0 || (command[0].size() >= 2 && command[0].substr(0, 2) == "//")) continue;
+		if(command[0] == "#enable" || command[0] == "#disable") continue;
+
+		scriptCommand_type parsed;
+		parsed.at = coordi(0, 0);
+		parsed.value = 0;
+
+		if(command[0] == "fire" && command.size() >= 2 && utilities::parseCoordinate(command[1], parsed.at)) parsed.action = script_fire;
+		else if(command[0] == "#setshots" && command.size() >= 2 && utilities::parseInt(command[1], parsed.value)) parsed.action = script_setShots;
+		else if(command[0] == "#killall") parsed.action = script_killAll;
+		else
+		{
+			script.badLines.push_back(lineNumber);
+			continue;
+		}
+
+		script.commands.push_back(parsed);
+	}
+}
+
+errorstates loadCommandScript(string filename, commandScript_type & script)		//Loads and parses the command script in 'filename' (see parseCommandScript()).  Returns file_notFound if it can't be opened
+{
+	mappedFile_type file(filename);
+	if(!file.isOpen()) return file_notFound;
+
+	parseCommandScript(file.data(), file.size(), script);
+	return noerror;
+}
+
+struct scriptBatchResult_type		//The results of replaying a command script against a batch of games
+{
+	int games = 0;
+	int wins = 0;
+	int losses = 0;
+	int unfinished = 0;			//Games still running when the script ran out
+	long long hits = 0;
+	long long misses = 0;
+	long long repeats = 0;		//Shots at cells that had already been fired at
+	long long offBoard = 0;		//Shots at cells that aren't on the board (these don't use a shot)
+	double seconds = 0;
+
+	void print()
+	{
+		cout << "games " << games << ": " << wins << " won, " << losses << " lost, " << unfinished << " unfinished" << endl;
+		cout << "shots " << (hits + misses + repeats) << ": " << hits << " hit, " << misses << " missed, " << repeats << " repeated, " << offBoard << " off the board" << endl;
+		cout << std::fixed << games / seconds << " games/sec" << endl;
+	}
+};
+
+//Replays 'script' against 'games' games in 'session'.  Every game is played on a copy of 'level', or if 'level' is nullptr, on a board generated from 'seed' + the game's number.
+//A game stops at the first win or loss, and the rest of the script is skipped for it.  Nothing is drawn.
+scriptBatchResult_type runScriptBatch(const commandScript_type & script, gameSession_type & session, int games, const gameBoard_type * level, uint64_t seed)
+{
+	scriptBatchResult_type result;
+	result.games = games;
+
+	auto start = std::chrono::steady_clock::now();
+	for(int game = 0; game < games; game++)
+	{
+		if(level != nullptr) session.newGame(*level);
+		else
+		{
+			session.reseed(seed + game);
+			session.newGame();
+		}
+
+		for(auto iter = script.commands.begin(); iter != script.commands.end() && session.getState() == running; iter++)
+		{
+			switch(iter->action)
+			{
+				case script_fire:
+				{
+					outcome_type<shotResult> shot = session.fire(iter->at);
+					if(!shot.ok()) result.offBoard++;
+					else if(shot.value == hit) result.hits++;
+					else if(shot.value == miss) result.misses++;
+					else if(shot.value == alreadyFired) result.repeats++;
+				}
+					break;
+
+				case script_setShots:
+					session.getBoard().setShots(iter->value);
+					session.updateState();
+					break;
+
+				case script_killAll:
+					session.getBoard().destroyAllShips();
+					session.updateState();
+					break;
+			}
+		}
+
+		switch(session.getState())
+		{
+			case win:
+				result.wins++;
+				break;
+
+			case lose:
+				result.losses++;
+				break;
+
+			default:
+				result.unfinished++;
+				break;
+		}
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return result;
+}
+
+//Batch mode: Battleship --batch <script> [--level <file> | --seed <number>] [--games <number>]
+//Replays the command script against the level (or boards generated from the seed, 1 by default) without using the console, and prints a summary.  Returns the program's exit code
+int runBatchMode(int argc, char * argv[])
+{
+	string scriptFile, levelFile;
+	int seed = 1;
+	int games = 1;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const std::string_view option = argv[i];
+		const bool hasValue = (i + 1 < argc);
+
+		if(option == "--batch" && hasValue) scriptFile = argv[++i];
+		else if(option == "--level" && hasValue) levelFile = argv[++i];
+		else if(option == "--seed" && hasValue && utilities::parseInt(argv[i + 1], seed)) i++;
+		else if(option == "--games" && hasValue && utilities::parseInt(argv[i + 1], games) && games > 0) i++;
+		else
+		{
+			cout << "Usage: " << argv[0] << " --batch <script> [--level <file> | --seed <number>] [--games <number>]" << endl;
+			return 1;
+		}
+	}
+
+	commandScript_type script;
+	errorstates error = (scriptFile.empty() ? file_notFound : loadCommandScript(scriptFile, script));
+	if(error != noerror)
+	{
+		cout << "Script \"" << scriptFile << "\": " << utilities::errorStateToString(error) << endl;
+		return 1;
+	}
+	for(auto iter = script.badLines.begin(); iter != script.badLines.end(); iter++)
+	{
+		cout << "Script line " << *iter << " was not understood, and was skipped." << endl;
+	}
+
+	gameSession_type session(coordi(25, 25));
+	gameBoard_type level(coordi(25, 25));
+	if(!levelFile.empty())
+	{
+		error = level.loadFromFile(levelFile);
+		if(error != noerror)
+		{
+			cout << "Level \"" << levelFile << "\": " << utilities::errorStateToString(error) << endl;
+			return 1;
+		}
+	}
+
+	runScriptBatch(script, session, games, (levelFile.empty() ? nullptr : &level), uint64_t(seed)).print();
+	return 0;
+}
+
+//Tournament mode: Battleship --tournament [--boards <number>] [--shooter <random|hunt|density>]... [--seed <number>] [--threads <number>]
+//Has each shooter (every one, if none are given) play the same boards generated from the seed (1 by default; 10000 boards by default), on every core unless told
+//otherwise, and prints them ranked.  Returns the program's exit code
+int runTournamentMode(int argc, char * argv[])
+{
+	vector<string> names;
+	int boards = 10000;
+	int seed = 1;
+	int threads = 0;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const std::string_view option = argv[i];
+		const bool hasValue = (i + 1 < argc);
+
+		if(option == "--tournament") continue;
+		else if(option == "--boards" && hasValue && utilities::parseInt(argv[i + 1], boards) && boards > 0) i++;
+		else if(option == "--shooter" && hasValue && makeShooter(argv[i + 1]) != nullptr) names.push_back(argv[++i]);
+		else if(option == "--seed" && hasValue && utilities::parseInt(argv[i + 1], seed)) i++;
+		else if(option == "--threads" && hasValue && utilities::parseInt(argv[i + 1], threads) && threads > 0) i++;
+		else
+		{
+			cout << "Usage: " << argv[0] << " --tournament [--boards <number>] [--shooter <random|hunt|density>]... [--seed <number>] [--threads <number>]" << endl;
+			return 1;
+		}
+	}
+	if(names.empty()) names = { "random", "hunt", "density" };
+
+	runTournament(names, boards, uint64_t(seed), threads).print(cout);
+	return 0;
+}
+
+namespace benchmarks
+{
+	void runAll(std::ostream & out);		//Defined with the rest of the benchmarks, below
+}
+
+//One player's game: the title menu, loading or generating a board, playing it, and the win/loss screens.  A session never waits for input itself.  start() and feed() run it
+//until it needs the next line the player types, and leave what to show the player (console text and screen frames, in order) in getOutput().  So one thread can run any
+//number of sessions, resuming each only when a line arrives for it: mainLoop() runs one on the console, and the server's --console mode runs one per connection
+class playerSession_type
+{
+public:
+	enum prompt_type		//What the session is waiting for the player to type
+	{
+		prompt_none,		//Nothing: the session hasn't started, or has finished
+		prompt_menu,		//A choice from the title menu
+		prompt_filename,	//The file to load a board from
+		prompt_command,		//A command, while playing
+		prompt_enter,		//Enter, to carry on after a message
+	};
+
+private:
+	gameState_type gameState = title;
+	prompt_type prompt = prompt_none;
+	const bool allowDebug;				//Whether debug commands may be turned on in this session
+	const bool allowFiles;				//Whether the player may load a board from any file they name.  Never for games served over a socket, where the files are the server's, not the player's
+
+	gameBoard_type gameBoard = gameBoard_type(coordi(25, 25));
+	vector<boardSnapshot_type> playerUndo;		//Snapshots of gameBoard from before each of the player's shots (and #killall/#setshots), newest last, for the undo command
+	journal_type playerJournal;					//The journal the #journal debug command records the player's games in
+	screenBuffer_type screen;
+	string output;						//What the player hasn't been shown yet
+
+	bool debugCommandsOn = false;		//Controls if debug commands are turned on
+	bool debug_forceRun = false;
+	bool debug_showShips = false;
+
+	void clearConsole()		//Clears the console
+	{
+		output += "\x1b[2J\x1b[H";	//Clear the screen and move the cursor to the top left
+		screen.invalidate();
+	}
+
+	void pushScreen()		//Adds the cells of the screen buffer that changed since the last push to the output
+	{
+		profiling::scopedTimer_type timer(profiling::phase_push);
+		const size_t before = output.size();
+		screen.composeFrame(output);
+		profiling::count(profiling::counter_consoleBytes, (long long)(output.size() - before));
+	}
+
+	void waitForEnter(const string & text)		//Shows 'text' on the console (the screen has already been cleared), and waits for the player to press enter before going on
+	{
+		output += text;
+		output += "\nPress enter to continue\n";
+		prompt = prompt_enter;
+	}
+
+	void printPlayerFeedback(string feedback)		//Prints 'feedback' for the player to the specific spot in the screen buffer reserved for it 
+	{
+		screen.clearRow(28);
+		screen.write(coordi(0, 28), feedback, true);
+	}
+
+	bool handleDebugCommands(const utilities::commandTokens_type & command)		//Checks for and executes debug commands in 'command' if they exist.  Returns 'true' if it is a debug command, false if not
+	{
+		if(command.size() == 0) return false;	//If the argument isn't a command, it can't be a debug command
+
+		if(command[0].size() > 0 && command[0][0] == '#' && allowDebug == true)		//Debug command handler (requires that allowDebugCommands be true to enable them)
+		{
+			const std::string_view name = command[0].substr(1);	//Trims the '#' from the beginning of the first term to make things more readable
+
+			if(debugCommandsOn == false)				//If debug commands are enabled
+			{
+				if(name == "enable")				//Enables debug commands
+				{
+					debugCommandsOn = true;
+					printPlayerFeedback("Debug commands enabled.  #disable to turn them off.");
+					return true;
+				}
+			}
+			else
+			{
+				if(name == "enable")				//Debug commands are already on, so we just say so. 
+				{
+					printPlayerFeedback("Debug commands are already enabled.");
+					return true;
+				}
+				else if(name == "disable")		//Disables debug commands
+				{
+					debugCommandsOn = false;
+					printPlayerFeedback("Debug commands are now disabled.");
+					return true;
+				}
+				else if(name == "setshots")		//Sets the number of shots the player has remaining
+				{
+					if(command.size() >= 2)
+					{
+						int shots;
+						if(utilities::parseInt(command[1], shots))
+						{
+							playerUndo.push_back(gameBoard.snapshot());
+							gameBoard.setShots(shots);
+						}
+						else printPlayerFeedback("\"" + string(command[1]) + "\" could not be converted to an integer.");
+					}
+				}
+				else if(name == "forcerun")	//Forces the game to run, preventing it from closing
+				{
+					debug_forceRun = true;
+				}
+				else if(name == "normalrun")	//Disables forceRun, returns the game to it's normal state
+				{
+					debug_forceRun = false;
+				}
+				else if(name == "showships")
+				{
+					debug_showShips = true;
+				}
+				else if(name == "hideships")
+				{
+					debug_showShips = false;
+				}
+				else if(name == "benchmark")	//Runs the micro-benchmarks and prints the results
+				{
+					clearConsole();
+					std::ostringstream text;
+					benchmarks::runAll(text);
+					waitForEnter(text.str());
+				}
+				else if(name == "profile")		//Turns the profiler on or off, clears it, or prints what it has gathered.  #profile <on|off|reset|dump>
+				{
+					const std::string_view action = command.size() >= 2 ? command[1] : std::string_view();
+					if(action == "on")
+					{
+						profiling::enabled = true;
+						printPlayerFeedback("Profiling on.  #profile dump prints the timings.");
+					}
+					else if(action == "off")
+					{
+						profiling::enabled = false;
+						printPlayerFeedback("Profiling off.");
+					}
+					else if(action == "reset")
+					{
+						profiling::reset();
+						printPlayerFeedback("Profiling data cleared.");
+					}
+					else if(action == "dump")
+					{
+						clearConsole();
+						std::ostringstream text;
+						profiling::report(text);
+						waitForEnter(text.str());
+					}
+					else printPlayerFeedback("Usage: #profile <on|off|reset|dump>");
+				}
+				else if(name == "aibatch")		//Has a computer player play a batch of games, and prints the results.  #aibatch <random|hunt|density> [games]
+				{
+					std::unique_ptr<shooter_type> shooter = makeShooter(command.size() >= 2 ? string(command[1]) : "density");
+					int games = 1000;
+					if(command.size() >= 3) utilities::parseInt(command[2], games);		//Left at 1000 if it isn't a number
+
+					if(shooter == nullptr || games < 1)
+					{
+						printPlayerFeedback("Usage: #aibatch <random|hunt|density> [games]");
+					}
+					else
+					{
+						clearConsole();
+						std::ostringstream text;
+						runShooterBatch(*shooter, games, uint64_t(std::time(NULL))).print(text);
+						waitForEnter(text.str());
+					}
+				}
+				else if(name == "solve")		//Counts the placements of the fleet that agree with the shots and the ships sunk so far, and names the unfired cell most likely to hold a ship.  #solve [stats]
+				{
+					if(command.size() >= 2 && command[1] == "stats")
+					{
+						const auto stats = solveCache.getStats();
+						char feedback[128];
+						snprintf(feedback, sizeof(feedback), "Cache: %llu lookups, %.0f%% hits, %llu collisions, %llu evictions.", (unsigned long long) stats.lookups,
+							100 * stats.hitRate(), (unsigned long long) stats.collisions, (unsigned long long) stats.evictions);
+						printPlayerFeedback(feedback);
+						return true;
+					}
+
+					const coordi boardSize = gameBoard.getBoardSize();
+					if(std::min(boardSize.x, boardSize.y) > posteriorSolver_type::maxWidth)		//Checked before observe(), which needs a byte for every cell
+					{
+						printPlayerFeedback(utilities::errorStateToString(solver_tooLarge));
+						return true;
+					}
+
+					solveSummary_type summary;
+					const bool cached = solveCache.lookup(gameBoard.getHash(), gameBoard.getHashCheck(), summary);
+					auto start = std::chrono::steady_clock::now();
+					if(!cached)
+					{
+						vector<uint8_t> cells;
+						vector<int> fleet;
+						vector<int> sunk;
+						posteriorSolver_type::observe(gameBoard, cells, fleet, sunk);
+
+						posteriorSolver_type solver;
+						posteriorSolver_type::result_type result;
+						errorstates err = solver.solve(gameBoard.getBoardSize(), cells, fleet, sunk, result, solveStateLimit);	//Capped, as the game waits on it
+						if(err == solver_tooLarge)		//Too many ways the ships afloat could lie to count them all in time, so estimate instead
+						{
+							random_type random(gameBoard.getHash());		//Seeded by the position, so it gets the same estimate every time
+							err = solver.estimate(gameBoard.getBoardSize(), cells, fleet, sunk, result, solveSamples, random);
+						}
+						if(err != noerror)
+						{
+							printPlayerFeedback(utilities::errorStateToString(err));
+							return true;
+						}
+
+						summary.placements = result.placements;
+						summary.estimated = result.estimated;
+						summary.best = -1;
+						summary.probability = 0;
+						for(size_t i = 0; i < cells.size() && result.placements > 0; i++)
+						{
+							if(cells[i] == posteriorSolver_type::seen_unknown && (summary.best < 0 || result.probability[i] > summary.probability))
+							{
+								summary.best = int(i);
+								summary.probability = result.probability[i];
+							}
+						}
+						solveCache.store(gameBoard.getHash(), gameBoard.getHashCheck(), summary);
+					}
+					const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+					int afloat = 0;
+					for(const shipRecord_type & record : gameBoard.getShips()) afloat += !record.isSunk();
+
+					if(summary.placements == 0 && summary.estimated) printPlayerFeedback("None of the placements of the fleet tried agrees with the shots so far.");
+					else if(summary.placements == 0) printPlayerFeedback("No placement of the fleet agrees with the shots so far.");
+					else if(summary.estimated)
+					{
+						const int width = gameBoard.getBoardSize().x;
+						char feedback[128];
+						snprintf(feedback, sizeof(feedback), "~%.2g placements, %d afloat.  Best shot %s%d (%.1f%%).  %s %.0f ms.", double(summary.placements), afloat,
+							utilities::columnName(summary.best % width).c_str(), summary.best / width, 100 * summary.probability, (cached ? "Cached estimate," : "Estimated in"), milliseconds);
+						printPlayerFeedback(feedback);
+					}
+					else
+					{
+						const int width = gameBoard.getBoardSize().x;
+						char feedback[128];
+						snprintf(feedback, sizeof(feedback), "%llu placements, %d ships afloat.  Best shot %s%d (%.1f%%).  %s %.0f ms.", (unsigned long long) summary.placements,
+							afloat, utilities::columnName(summary.best % width).c_str(), summary.best / width, 100 * summary.probability, (cached ? "From the cache in" : "Solved in"), milliseconds);
+						printPlayerFeedback(feedback);
+					}
+				}
+				else if(name == "save")		//Saves the current board as a binary level.  #save <file>
+				{
+					if(command.size() < 2) printPlayerFeedback("Usage: #save <file>");
+					else
+					{
+						errorstates err = gameBoard.saveToBinary(string(command[1]));
+						if(err == noerror) printPlayerFeedback("Saved the board to \"" + string(command[1]) + "\".");
+						else printPlayerFeedback(utilities::errorStateToString(err));
+					}
+				}
+				else if(name == "convert")	//Converts a level between the text and binary formats.  #convert <from> <to>
+				{
+					if(command.size() < 3) printPlayerFeedback("Usage: #convert <from> <to>");
+					else
+					{
+						errorstates err = convertLevel(string(command[1]), string(command[2]));
+						if(err == noerror) printPlayerFeedback("Converted \"" + string(command[1]) + "\" to \"" + string(command[2]) + "\".");
+						else printPlayerFeedback(utilities::errorStateToString(err));
+					}
+				}
+				else if(name == "journal")		//Starts recording the game in a journal, or stops.  #journal <file|off>
+				{
+					if(command.size() < 2) printPlayerFeedback("Usage: #journal <file|off>");
+					else if(command[1] == "off")
+					{
+						gameBoard.setJournal(nullptr);
+						errorstates err = playerJournal.flush();
+						playerJournal.close();
+						printPlayerFeedback(err == noerror ? "Stopped recording the game." : utilities::errorStateToString(err));
+					}
+					else
+					{
+						errorstates err = playerJournal.open(string(command[1]));
+						if(err == noerror)
+						{
+							gameBoard.setJournal(&playerJournal, true);
+							printPlayerFeedback("Recording the game in \"" + string(command[1]) + "\".  New boards start a new game in the journal.");
+						}
+						else printPlayerFeedback(utilities::errorStateToString(err));
+					}
+				}
+				else if(name == "replay")		//Sets the board to how it was after a turn of a game in a journal.  #replay <file> <turn> [game, the last one by default]
+				{
+					int turn = 0;
+					if(command.size() < 3 || !utilities::parseInt(command[2], turn)) printPlayerFeedback("Usage: #replay <file> <turn> [game]");
+					else
+					{
+						playerJournal.flush();		//In case it's the journal being recorded
+
+						journalReader_type reader{ string(command[1]) };
+						int game = reader.getGameCount() - 1;
+						if(command.size() >= 4 && utilities::parseInt(command[3], game)) game--;	//Games are numbered from 1 for the player
+
+						outcome_type<int> reached = reader.seek(game, turn, gameBoard);
+						if(reached.ok()) printPlayerFeedback("Showing game " + utilities::toString(game + 1) + " after turn " + utilities::toString(reached.value) + ".");
+						else if(reached.error == board_badX) printPlayerFeedback("The journal doesn't have that game.");
+						else printPlayerFeedback(utilities::errorStateToString(reached.error));
+					}
+				}
+				else if(name == "killall")
+				{
+					playerUndo.push_back(gameBoard.snapshot());
+					gameBoard.destroyAllShips();
+				}
+				else if(name == "ocean")		//Starts a game on a randomly generated board of any size (up to 1048576 x 1048576), with ships of the usual lengths.  #ocean <width> <height> [ships]
+				{
+					int width = 0, height = 0;
+					int shipCount = int(gameBoard_type::defaultFleet().size());
+					if(command.size() < 3 || !utilities::parseInt(command[1], width) || !utilities::parseInt(command[2], height) || (command.size() >= 4 && !utilities::parseInt(command[3], shipCount))
+						|| width < 1 || height < 1 || width > (1 << 20) || height > (1 << 20) || shipCount < 1)
+					{
+						printPlayerFeedback("Usage: #ocean <width> <height> [ships]");
+					}
+					else
+					{
+						vector<int> fleet(shipCount);
+						for(int i = 0; i < shipCount; i++)
+						{
+							fleet[i] = gameBoard_type::defaultFleet()[i % gameBoard_type::defaultFleet().size()];
+						}
+
+						gameBoard.setBoardSize(coordi(width, height));
+						if(gameBoard.placeFleet(fleet))
+						{
+							gameBoard.setShots(gameBoard.getMaxShots());
+							char feedback[128];
+							snprintf(feedback, sizeof(feedback), "A %dx%d ocean with %d ships, stored in %.1f KB.", width, height, shipCount, gameBoard.getMemoryUsed() / 1024.0);
+							printPlayerFeedback(feedback);
+						}
+						else printPlayerFeedback(utilities::errorStateToString(board_gen_noRoom));
+					}
+				}
+			}
+		}
+		else return false;
+
+		return true;
+	}
+
+	void endScreen(string feedback)		//Shows the whole board, with the win/loss message in 'feedback', until the player presses enter to go back to the title screen
+	{
+		gameBoard.print(screen, true);
+
+		screen.clearRow(28);
+		screen.clearRow(29);
+
+		printPlayerFeedback(feedback);
+		screen.write(coordi(0, 29), "Press enter to return to the title screen.");
+		pushScreen();
+
+		gameState = title;
+		prompt = prompt_enter;
+	}
+
+	void updateGameState()		//Checks the game board for win/loss conditions, and moves the game to the win/loss screen if the game is over
+	{
+		gameState_type result = gameBoard.checkWinLoss();
+		if(result != running) gameState = result;
+	}
+
+	void showTitle()		//Shows the title menu
+	{
+		clearConsole();
+		playerUndo.clear();		//Whatever is played next is on a new board
+		screen.clearRow(28);	//Clear the row used for feedback on the buffer, in case the game has already been run once
+
+		output += "Please select an option:\n";
+		output += (allowFiles ? "1) Load game board from file\n" : "1) Load game board from file (not available here)\n");
+		output += "2) Generate new game board\n";
+		output += "3) Quit\n";
+		prompt = prompt_menu;
+	}
+
+	void chooseFromMenu(const string & input)
+	{
+		const outcome_type<int> choice = (input.size() == 0 ? outcome_type<int>(convert_fail_charInt) : utilities::toNum(input[0]));
+		if(!choice.ok() || choice.value < 1 || 3 < choice.value)		//Anything that isn't a digit is as invalid as a digit that isn't on the menu
+		{
+			output += "I'm sorry, I don't understand \"" + input + "\".  Please try again.\n";
+			prompt = prompt_menu;
+		}
+		else if(input[0] == '1' && !allowFiles)
+		{
+			output += "I'm sorry, game boards can't be loaded from files here.  Please choose another option.\n";
+			prompt = prompt_menu;
+		}
+		else if(input[0] == '1')
+		{
+			screen.clearRow(29);
+			screen.write(coordi(0, 29), "Please enter a command, Admiral.");
+			output += "\nPlease enter a file to open:";
+			prompt = prompt_filename;
+		}
+		else if(input[0] == '2')
+		{
+			screen.clearRow(29);
+			screen.write(coordi(0, 29), "Please enter a command, Admiral.");
+			//Generate a new game board
+			output += "Please be patient, this may take a second...\n";
+			gameBoard.setBoardSize(coordi(25, 25));
+			if(gameBoard.generateGameBoard()) gameState = running;
+			else waitForEnter(utilities::errorStateToString(board_gen_noRoom));		//Back to the title menu after
+		}
+		else gameState = quitting;
+	}
+
+	void loadBoard(const string & filename)		//Loads the game board from 'filename', or generates one if it can't be loaded.  Only reached if 'allowFiles' is true
+	{
+		if(filename == "")
+		{
+			output += "Please enter a filename.\n\nPlease enter a file to open:";
+			prompt = prompt_filename;
+			return;
+		}
+
+		output += "Attempting to load level data...\n";
+		gameBoard.setBoardSize(coordi(25, 25));		//Text levels are always 25x25 (binary levels set their own size), whatever size the last board was
+		errorstates error = gameBoard.loadFromFile(filename);
+		gameState = running;
+		if(error == noerror)
+		{
+			std::ostringstream text;
+			if(gameBoard.printErrors(text)) waitForEnter(text.str());
+		}
+		else
+		{
+			if(error == file_notFound) output += "An error was encoutered: The file could not be found.\n";
+			else output += "An error was encountered: " + utilities::errorStateToString(error) + "\n";
+			output += "Generating new game board...\n";
+			output += "Please be patient, this may take a second...\n";
+			if(!gameBoard.generateGameBoard()) output += utilities::errorStateToString(board_gen_noRoom) + "\n";
+		}
+	}
+
+	void showBoard()		//Shows the board, and waits for a command (or goes to the win/loss screen if the game is over)
+	{
+		//Check for win/loss conditions
+		updateGameState();
+
+		//Push the newest data to the screen
+		gameBoard.print(screen, debug_showShips && debugCommandsOn);
+		pushScreen();
+
+		if(gameState == running || debugCommandsOn) prompt = prompt_command;
+		else runCommand(string());
+	}
+
+	void runCommand(string commandLine)		//Carries out a command typed while the board is shown
+	{
+		utilities::commandTokens_type command;		//Views into 'commandLine', so splitting the command up doesn't copy it
+		{
+			profiling::scopedTimer_type timer(profiling::phase_input);		//Only the parsing is timed, not the wait for the player
+			utilities::toLowerInPlace(commandLine);
+			utilities::tokenize(commandLine, command);
+		}
+
+		screen.clearRow(28);		//Clear the row used for feedback
+
+		if(debug_forceRun && debugCommandsOn) gameState = running;
+
+		if(gameState == lose) endScreen("We've lost, Admiral.");
+		else if(gameState == win) endScreen("We've won, Admiral!");
+		if(gameState != running) return;
+
+		if(handleDebugCommands(command))
+		{
+			//Do nothing because the command was already handled
+		}
+		else if(command.size() == 0)
+		{
+			//The user typed nothing
+		}
+		else if(command[0] == "fire")
+		{
+			if(gameState != running)
+			{
+				printPlayerFeedback("This command cannot be used at this time.");
+			}
+			else
+			{
+				if(command.size() < 2)
+				{
+					printPlayerFeedback("Please specify a firing coordinate.");
+				}
+				else
+				{
+					const std::string_view pos = command[1];
+					coordi at;
+
+					if(!utilities::parseCoordinate(pos, at))		//If the first character is not a letter, or the remaining text is not a number
+					{
+						printPlayerFeedback("Sorry Admiral, firing coordinate \"" + string(pos) + "\" is invalid.  Please try again.");
+					}
+					else
+					{
+						const boardSnapshot_type beforeShot = gameBoard.snapshot();
+						outcome_type<shotResult> shot = gameBoard.fire(at);
+
+						if(!shot.ok())	//If the user fired at an invalid point
+						{
+							printPlayerFeedback("Sorry Admiral, firing coordinate \"" + string(pos) + "\" is invalid.  Please try again.");
+						}
+						else
+						{
+							shotResult result = shot.value;
+							playerUndo.push_back(beforeShot);
+
+							gameBoard.scrollToShow(at);		//So the shot can be seen on boards too big for the screen
+							updateGameState();
+
+							if(result == shotResult::alreadyFired)
+							{
+								printPlayerFeedback("You already fired on that location.");
+							}
+							else if(result == shotResult::hit)
+							{
+								const shipRecord_type * sunk = gameBoard.getLastSunkShip();
+								if(sunk != nullptr) printPlayerFeedback("Confirmed hit Admiral!  We sunk a ship of length " + utilities::toString(sunk->length) + "!");
+								else printPlayerFeedback("Confirmed hit Admiral!");
+							}
+							else if(result == shotResult::miss)
+							{
+								printPlayerFeedback("We didn't hit anything Admiral.");
+							}
+						}
+					}
+				}
+
+			}
+
+
+		}
+		else if(command[0] == "undo")		//Takes back the last shot (or #killall/#setshots)
+		{
+			if(playerUndo.empty() || gameBoard.rollback(playerUndo.back()) != noerror)		//A snapshot from an earlier board is stale, and so is every one before it
+			{
+				playerUndo.clear();
+				printPlayerFeedback("There's nothing to undo, Admiral.");
+			}
+			else
+			{
+				playerUndo.pop_back();
+				printPlayerFeedback("Order countermanded, Admiral.  " + utilities::toString(gameBoard.getShots()) + " shots remaining.");
+			}
+		}
+		else if(command[0] == "view")		//Centers the screen on a cell, for boards too big to fit on it.  view <coordinate>
+		{
+			coordi at;
+			if(command.size() < 2 || !utilities::parseCoordinate(command[1], at) || !gameBoard.isValidPosition(at))
+			{
+				printPlayerFeedback("Please specify a coordinate on the board to view, i.e. view B5.");
+			}
+			else gameBoard.centerOn(at);
+		}
+		else if(command[0] == "scroll")		//Moves the screen across the board.  scroll <up|down|left|right> [cells, a screen by default]
+		{
+			int cells = 25;
+			if(command.size() >= 3 && (!utilities::parseInt(command[2], cells) || cells < 0)) cells = -1;
+
+			coordi step(0, 0);
+			if(command.size() >= 2 && command[1] == "up") step = coordi(0, -1);
+			else if(command.size() >= 2 && command[1] == "down") step = coordi(0, 1);
+			else if(command.size() >= 2 && command[1] == "left") step = coordi(-1, 0);
+			else if(command.size() >= 2 && command[1] == "right") step = coordi(1, 0);
+
+			if(cells < 0 || (step.x == 0 && step.y == 0)) printPlayerFeedback("Usage: scroll <up|down|left|right> [cells]");
+			else
+			{
+				cells = std::min(cells, 1 << 21);		//Further than any board goes, and small enough not to overflow
+				const coordi view = gameBoard.getView();
+				gameBoard.scrollTo(coordi(view.x + step.x * cells, view.y + step.y * cells));
+			}
+		}
+	}
+
+	void run()		//Runs the session until it needs the player to type something, or it finishes
+	{
+		while(prompt == prompt_none && gameState != quitting)
+		{
+			if(gameState == title) showTitle();
+			else showBoard();
+		}
+	}
+
+public:
+	playerSession_type(bool debugAllowed, bool filesAllowed) : allowDebug(debugAllowed), allowFiles(filesAllowed)
+	{
+		screen.setSize(coordi(77, 30));
+
+		//Draw border for game board
+		{
+			const int xMin = 2;
+			const int xMax = 52;
+			const int yMin = 1;
+			const int yMax = 27;
+
+			//Top and bottom border
+			for(int x = xMin; x < xMax; x++)
+			{
+				screen.write(coordi(x, yMin), char(205));
+				screen.write(coordi(x, yMax), char(205));
+			}
+
+			//The left and right border
+			for(int y = yMin; y < yMax; y++)
+			{
+				screen.write(coordi(xMin, y), char(186));
+				screen.write(coordi(xMax, y), char(186));
+			}
+
+			//The corners
+			screen.write(coordi(xMin, yMin), char(201));	//Top left
+			screen.write(coordi(xMax, yMin), char(187));	//Top right
+			screen.write(coordi(xMin, yMax), char(200));	//Bottom left
+			screen.write(coordi(xMax, yMax), char(188));	//Bottom right
+
+			//game board title 
+			screen.write(coordi(xMin + 19, yMin), char(185));	//The left and right borders for the title
+			screen.write(coordi(xMin + 30, yMin), char(204));
+			screen.write(coordi(xMin + 20, yMin), "Game Board");
+		}
+
+		//The coordinate indexes along the edge of the board are written by gameBoard_type::print(), as they change when the board is scrolled
+
+		//Draw the instructions to the right side of the screen
+		{
+			const int menuX = 54;
+			const int menuY = 2;
+
+			screen.write(coordi(menuX, menuY), "Key:");
+			screen.write(coordi(menuX, menuY + 1), "~ = ocean tile");
+			screen.write(coordi(menuX, menuY + 2), "H = hit");
+			screen.write(coordi(menuX, menuY + 3), "M = miss");
+
+			screen.write(coordi(menuX, menuY + /*5*/7), "Commands:");
+			//screen.write(coordi(menuX, menuY + 6), "help");
+			//screen.write(coordi(menuX, menuY + 7), "   shows help");
+
+			screen.write(coordi(menuX, menuY + 9), "fire <letter><number>");
+			screen.write(coordi(menuX, menuY + 10), "   fires at the");
+			screen.write(coordi(menuX, menuY + 11), "   specified location");
+			screen.write(coordi(menuX, menuY + 12), "   ex: fire A5");
+			screen.write(coordi(menuX, menuY + 23), "undo");
+			screen.write(coordi(menuX, menuY + 24), "   takes back a shot");
+
+			screen.write(coordi(menuX, menuY + 14), "Shots remaining:");
+
+		}
+	}
+
+	void start()		//Starts the session by asking the player to resize their console window so the whole screen fits
+	{
+		output += "You should be able to see this message along with the bottom one.\n";
+		output.append(27, '\n');
+		output += "Please resize your window so that you can see this message and the\nmessage at the top at the same time.\n";
+		output += "Please press enter when you're done.";
+		prompt = prompt_enter;		//Then the title menu, which clears the console
+	}
+
+	void feed(const string & line)		//Gives the session the next line the player typed (without the newline), and runs it until it needs another
+	{
+		const prompt_type answering = prompt;
+		prompt = prompt_none;
+
+		if(answering == prompt_menu) chooseFromMenu(line);
+		else if(answering == prompt_filename) loadBoard(line);
+		else if(answering == prompt_command) runCommand(line);
+		run();
+	}
+
+	prompt_type getPrompt() { return prompt; }
+	bool isFinished() { return gameState == quitting; }
+
+	string & getOutput() { return output; }		//What to show the player: console text and escape sequences.  The caller clears it once it has been shown
+
+	size_t getMemoryUsed()		//Roughly how many bytes the session is using, including the journal's buffer while #journal is recording
+	{
+		const coordi size = screen.getSize();
+		return sizeof(*this) - sizeof(playerJournal) + playerJournal.getMemoryUsed() + gameBoard.getMemoryUsed() + 2 * size_t(size.x) * size.y + output.capacity() + playerUndo.capacity() * sizeof(boardSnapshot_type);
+	}
+};
+
+namespace benchmarks		//Micro-benchmarks for the hot parts of the game, run with the #benchmark debug command
+{
+	typedef std::chrono::steady_clock clock_type;
+
+	double secondsSince(clock_type::time_point start)	//Returns the number of seconds that have passed since 'start'
+	{
+		return std::chrono::duration<double>(clock_type::now() - start).count();
+	}
+
+	struct result_type		//The outcome of one benchmark
+	{
+		string name;
+		double rate;		//Operations per second
+		string unit;		//What an 'operation' is
+	};
+
+	void printResult(const result_type & result, std::ostream & out)
+	{
+		out << result.name << ": " << std::fixed << result.rate << " " << result.unit << "/sec" << endl;
+	}
+
+	void writeResults(const vector<result_type> & results, bool json, std::ostream & out)	//Writes 'results' so a script can read them: tab separated with a header line, or a JSON array
+	{
+		char rate[32];
+		if(!json) out << "benchmark\trate\tunit" << endl;
+		else out << "[" << endl;
+
+		for(size_t i = 0; i < results.size(); i++)
+		{
+			snprintf(rate, sizeof(rate), "%.3f", results[i].rate);
+			if(!json)
+			{
+				out << results[i].name << '\t' << rate << '\t' << results[i].unit << "/sec" << endl;
+				continue;
+			}
+
+			string name;		//The names never contain quotes today, but escape them anyway so the output stays valid JSON
+			for(char c : results[i].name)
+			{
+				if(c == '"' || c == '\\') name += '\\';
+				name += c;
+			}
+			out << "\t{ \"benchmark\": \"" << name << "\", \"rate\": " << rate << ", \"unit\": \"" << results[i].unit << "/sec\" }" << (i + 1 < results.size() ? "," : "") << endl;
+		}
+
+		if(json) out << "]" << endl;
+	}
+
+	//The layout gameBoard_type used before the bit board, kept here so the two can be compared
+	struct nestedVectorBoard_type
+	{
+		vector<vector<cellContents_type>> board;
+
+		nestedVectorBoard_type(coordi size) : board(size.x, vector<cellContents_type>(size.y, ocean)) {}
+
+		cellContents_type get(int x, int y) { return board[x][y]; }
+		void set(int x, int y, cellContents_type cell) { board[x][y] = cell; }
+	};
+
+	//Fills a board with a fixed pattern, then walks it row-major the way print() and checkWinLoss() do.  Returns cells/sec.
+	template <typename board_type> double boardStorageRate(board_type & board, coordi size, int passes)
+	{
+		volatile int sink = 0;		//Keeps the optimizer from throwing the reads away
+		clock_type::time_point start = clock_type::now();
+
+		for(int pass = 0; pass < passes; pass++)
+		{
+			for(int y = 0; y < size.y; y++)
+			{
+				for(int x = 0; x < size.x; x++)
+				{
+					board.set(x, y, ((x * 7 + y * 3 + pass) % 5 == 0) ? ship : ocean);
+				}
+			}
+
+			int ships = 0;
+			for(int y = 0; y < size.y; y++)
+			{
+				for(int x = 0; x < size.x; x++)
+				{
+					if(board.get(x, y) == ship) ships++;
+				}
+			}
+			sink = sink + ships;
+		}
+
+		return double(passes) * size.x * size.y * 2 / secondsSince(start);
+	}
+
+	vector<result_type> boardStorage(coordi size, int passes)		//Compares cells/sec of the bit board against the old nested-vector layout
+	{
+		struct bitBoardAdapter_type
+		{
+			bitBoard_type board;
+			cellContents_type get(int x, int y) { return board.getCell(x, y); }
+			void set(int x, int y, cellContents_type cell) { board.setCell(x, y, cell); }
+		} bits;
+		bits.board.resize(size);
+
+		nestedVectorBoard_type nested(size);
+
+		const string label = " " + util::toString(size.x) + "x" + util::toString(size.y);
+
+		vector<result_type> results;
+		results.push_back({ "cell access (nested vector)" + label, boardStorageRate(nested, size, passes), "cells" });
+		results.push_back({ "cell access (bit board)" + label, boardStorageRate(bits, size, passes), "cells" });
+
+		//Counting the live ships, the way checkWinLoss() does: cell by cell on the old layout, word by word on the bit board
+		{
+			volatile int sink = 0;
+			clock_type::time_point start = clock_type::now();
+			for(int pass = 0; pass < passes; pass++)
+			{
+				int ships = 0;
+				for(int y = 0; y < size.y; y++)
+				{
+					for(int x = 0; x < size.x; x++)
+					{
+						if(nested.get(x, y) == ship) ships++;
+					}
+				}
+				sink = sink + ships;
+			}
+			results.push_back({ "live ship count (nested vector)" + label, double(passes) * size.x * size.y / secondsSince(start), "cells" });
+		}
+		{
+			volatile int sink = 0;
+			clock_type::time_point start = clock_type::now();
+			for(int pass = 0; pass < passes; pass++)
+			{
+				sink = sink + bits.board.countLiveShipCells();
+			}
+			results.push_back({ "live ship count (bit board)" + label, double(passes) * size.x * size.y / secondsSince(start), "cells" });
+		}
+
+		return results;
+	}
+
+	//The generator gameBoard_type used before placeFleet(): random position and direction, retrying whenever createShip() reports an overlap
+	void legacyGenerate(gameBoard_type & board, const vector<int> & lengths)
+	{
+		board.emptyBoard();
+		coordi size = board.getBoardSize();
+
+		for(int iter = 0; iter < int(lengths.size()); iter++)
+		{
+			int length = lengths[iter];
+			direction_type dir = direction_type(util::rand(0, 3).value);
+
+			int xMin = (dir == west ? length : 0);
+			int xMax = (dir == east ? size.x - length : size.x - 1);
+			int yMin = (dir == north ? length : 0);
+			int yMax = (dir == south ? size.y - length : size.y - 1);
+
+			if(board.createShip(coordi(util::rand(xMin, xMax).value, util::rand(yMin, yMax).value), dir, length) != noerror) iter--;
+		}
+	}
+
+	vector<result_type> boardGeneration(coordi size, const vector<int> & fleet, int boards)		//Measures boards/sec of placeFleet() against the old retry-on-exception generator
+	{
+		gameBoard_type board(size);
+		const string label = " " + util::toString(size.x) + "x" + util::toString(size.y) + ", " + util::toString(int(fleet.size())) + " ships";
+
+		vector<result_type> results;
+		{
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < boards; i++)
+			{
+				legacyGenerate(board, fleet);
+			}
+			results.push_back({ "board generation (retry on overlap)" + label, boards / secondsSince(start), "boards" });
+		}
+		{
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < boards; i++)
+			{
+				board.placeFleet(fleet);
+			}
+			results.push_back({ "board generation (candidate sampling)" + label, boards / secondsSince(start), "boards" });
+		}
+		return results;
+	}
+
+	vector<result_type> batchGeneration(int boards)		//Measures boards/sec of generateBoards() on one thread and on every core
+	{
+		vector<gameBoard_type> batch(boards, gameBoard_type(coordi(25, 25)));
+		vector<result_type> results;
+
+		vector<int> threadCounts {1};
+		if(std::thread::hardware_concurrency() > 1) threadCounts.push_back(int(std::thread::hardware_concurrency()));
+
+		for(int threads : threadCounts)
+		{
+			clock_type::time_point start = clock_type::now();
+			generateBoards(batch, gameBoard_type::defaultFleet(), 12345, threads);
+			results.push_back({ "batch board generation 25x25, " + util::toString(threads) + " thread(s)", boards / secondsSince(start), "boards" });
+		}
+		return results;
+	}
+
+	vector<result_type> boardFiring(coordi size, int games)		//Measures fire() and checkWinLoss() calls/sec on their own, sweeping a generated board row by row until every ship is sunk
+	{
+		gameBoard_type board(size);
+		const string label = " " + util::toString(size.x) + "x" + util::toString(size.y);
+		long long shotCount = 0;
+		double fireSeconds = 0;
+
+		for(int game = 0; game < games; game++)
+		{
+			board.generateGameBoard();
+			board.setShots(size.x * size.y);
+
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < size.x * size.y && board.getLiveShipCells() > 0; i++)
+			{
+				board.fire(coordi(i % size.x, i / size.x));
+				shotCount++;
+			}
+			fireSeconds += secondsSince(start);
+		}
+
+		//checkWinLoss() is timed on a board still in play, so it can't return early on a win
+		board.generateGameBoard();
+		board.setShots(1);
+		long long inPlay = 0;
+		clock_type::time_point start = clock_type::now();
+		for(long long i = 0; i < shotCount; i++)
+		{
+			inPlay += (board.checkWinLoss() == running);
+		}
+		const double checkSeconds = secondsSince(start);
+		if(inPlay != shotCount) cout << "checkWinLoss() benchmark: the board wasn't in play" << endl;
+
+		return { { "fire" + label, shotCount / fireSeconds, "shots" }, { "win check" + label, shotCount / checkSeconds, "checks" } };
+	}
+
+	//Fills in what a player would know after the density shooter has fired 'shots' shots at a 25x25 board in game 'seed'
+	void shotPosition(uint64_t seed, int shots, vector<uint8_t> & cells, vector<int> & fleet, vector<int> & sunk)
+	{
+		gameSession_type session(coordi(25, 25), seed);
+		session.newGame();
+		session.getBoard().setShots(625);
+		densityShooter_type shooter;
+		shooter.newGame(coordi(25, 25), gameBoard_type::defaultFleet(), seed);
+		for(int i = 0; i < shots && session.getState() == running; i++)
+		{
+			coordi at = shooter.nextShot();
+			shotResult shot = session.fire(at).value;
+			shooter.recordShot(at, shot, session.getShotLog().back().sunkLength);
+		}
+		posteriorSolver_type::observe(session.getBoard(), cells, fleet, sunk);
+	}
+
+	result_type posteriorSolving(int shots, int solves)		//Measures solves/sec of posteriorSolver_type on a 25x25 board the density shooter has fired 'shots' shots at
+	{
+		vector<uint8_t> cells;
+		vector<int> fleet;
+		vector<int> sunk;
+		shotPosition(3, shots, cells, fleet, sunk);
+
+		posteriorSolver_type solver;
+		posteriorSolver_type::result_type result;
+		clock_type::time_point start = clock_type::now();
+		for(int i = 0; i < solves; i++)
+		{
+			solver.solve(coordi(25, 25), cells, fleet, sunk, result);
+		}
+		return { "posterior solve 25x25, " + util::toString(shots) + " shots, " + util::toString(int(fleet.size() - sunk.size())) + " ships afloat", solves / secondsSince(start), "solves" };
+	}
+
+	//Measures estimates/sec of posteriorSolver_type::estimate() with as many samples as #solve uses, on a 25x25 board the density shooter has fired 'shots' shots at in game
+	//'seed'.  If the board can be solved exactly within #solve's limit, checks the estimate against it: every cell's chance within 0.05, the placements within 10%
+	result_type posteriorEstimating(uint64_t seed, int shots, int estimates)
+	{
+		vector<uint8_t> cells;
+		vector<int> fleet;
+		vector<int> sunk;
+		shotPosition(seed, shots, cells, fleet, sunk);
+
+		posteriorSolver_type solver;
+		posteriorSolver_type::result_type result;
+		random_type random(seed);
+		clock_type::time_point start = clock_type::now();
+		for(int i = 0; i < estimates; i++)
+		{
+			solver.estimate(coordi(25, 25), cells, fleet, sunk, result, solveSamples, random);
+		}
+		const double rate = estimates / secondsSince(start);
+
+		posteriorSolver_type::result_type exact;
+		if(estimates > 0 && solver.solve(coordi(25, 25), cells, fleet, sunk, exact, solveStateLimit) == noerror)
+		{
+			double worst = 0;
+			for(size_t i = 0; i < cells.size(); i++) worst = std::max(worst, std::abs(result.probability[i] - exact.probability[i]));
+			const double ratio = (exact.placements > 0 ? double(result.placements) / double(exact.placements) : (result.placements == 0 ? 1.0 : 0.0));
+			if(worst > 0.05 || ratio < 0.9 || ratio > 1.1)
+			{
+				cout << "posterior estimate benchmark: " << result.placements << " placements estimated against " << exact.placements << ", and a cell's chance off by " << worst << endl;
+			}
+		}
+		return { "posterior estimate 25x25, " + util::toString(shots) + " shots, " + util::toString(int(fleet.size() - sunk.size())) + " ships afloat", rate, "estimates" };
+	}
+
+	//Checks posteriorSolver_type against a brute-force count on 'positions' small positions, and measures positions/sec of the brute force and the solver together.  Each
+	//position is a 7x5 board with a fleet that has two ships of the same length, and some random shots at it.  The brute force lists every placement of the fleet (ships
+	//may touch but not cross, ships of the same length are told apart only by where they are), and keeps those that cover every hit and no miss and whose ships lying
+	//wholly on hits have the lengths of the ships sunk
+	result_type posteriorCrossCheck(int positions)
+	{
+		const coordi size(7, 5);
+		const int area = size.x * size.y;
+		const vector<int> shipLengths { 3, 2, 2 };
+
+		struct placement_type
+		{
+			int length;
+			uint64_t cells;		//A bit per cell, row-major
+		};
+		vector<placement_type> placements;
+		for(int length : shipLengths)
+		{
+			if(!placements.empty() && placements.back().length == length) continue;
+			for(int y = 0; y < size.y; y++)
+			{
+				for(int x = 0; x < size.x; x++)
+				{
+					for(int vertical = 0; vertical < 2; vertical++)
+					{
+						if((vertical ? y : x) + length > (vertical ? size.y : size.x)) continue;
+						uint64_t cells = 0;
+						for(int k = 0; k < length; k++) cells |= uint64_t(1) << ((vertical ? y + k : y) * size.x + (vertical ? x : x + k));
+						placements.push_back({ length, cells });
+					}
+				}
+			}
+		}
+
+		gameSession_type session(size, 11);
+		random_type random(11);
+		posteriorSolver_type solver;
+		posteriorSolver_type::result_type result;
+		int wrong = 0;
+
+		clock_type::time_point start = clock_type::now();
+		for(int position = 0; position < positions; position++)
+		{
+			session.newGame(shipLengths);
+			session.getBoard().setShots(area);
+			const int shots = int(random.below(area));
+			for(int i = 0; i < shots && session.getState() == running; i++)
+			{
+				session.fire(coordi(int(random.below(size.x)), int(random.below(size.y))));
+			}
+
+			vector<uint8_t> cells;
+			vector<int> fleet;
+			vector<int> sunk;
+			posteriorSolver_type::observe(session.getBoard(), cells, fleet, sunk);
+			std::sort(sunk.begin(), sunk.end());
+
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			for(int i = 0; i < area; i++)
+			{
+				if(cells[i] == posteriorSolver_type::seen_hit) hits |= uint64_t(1) << i;
+				else if(cells[i] == posteriorSolver_type::seen_miss) misses |= uint64_t(1) << i;
+			}
+
+			uint64_t count = 0;
+			vector<uint64_t> covering(area, 0);
+			vector<int> chosen;
+			auto place = [&](auto & self, size_t ship, size_t first, uint64_t used) -> void		//Places shipLengths[ship] onwards, the same length in increasing order
+			{
+				if(ship == shipLengths.size())
+				{
+					if((used & hits) != hits) return;
+					vector<int> wholeOnHits;
+					for(int index : chosen)
+					{
+						if((placements[index].cells & hits) == placements[index].cells) wholeOnHits.push_back(placements[index].length);
+					}
+					std::sort(wholeOnHits.begin(), wholeOnHits.end());
+					if(wholeOnHits != sunk) return;
+
+					count++;
+					for(int i = 0; i < area; i++) covering[i] += (used >> i) & 1;
+					return;
+				}
+
+				for(size_t i = first; i < placements.size(); i++)
+				{
+					if(placements[i].length != shipLengths[ship] || (placements[i].cells & (used | misses)) != 0) continue;
+					chosen.push_back(int(i));
+					self(self, ship + 1, (ship + 1 < shipLengths.size() && shipLengths[ship + 1] == shipLengths[ship] ? i + 1 : 0), used | placements[i].cells);
+					chosen.pop_back();
+				}
+			};
+			place(place, 0, 0, 0);
+
+			bool agrees = (solver.solve(size, cells, fleet, sunk, result) == noerror && result.placements == count);
+			for(int i = 0; i < area && agrees; i++)
+			{
+				const double difference = result.probability[i] - (count == 0 ? 0.0 : double(covering[i]) / count);
+				agrees = (difference < 1e-9 && difference > -1e-9);
+			}
+			if(!agrees) wrong++;
+		}
+		const double seconds = secondsSince(start);
+
+		if(wrong != 0) cout << "posterior cross-check benchmark: the solver disagreed with the brute force on " << wrong << " of " << positions << " positions" << endl;
+		return { "posterior solver cross-checked against brute force 7x5", positions / seconds, "positions" };
+	}
+
+	result_type headlessShots(int games)		//Measures shots/sec of gameSession_type, sweeping the board row by row until each game ends
+	{
+		gameSession_type session(coordi(25, 25), 1);
+		long long shotCount = 0;
+
+		clock_type::time_point start = clock_type::now();
+		for(int game = 0; game < games; game++)
+		{
+			session.newGame();
+			for(int i = 0; session.getState() == running; i++)
+			{
+				session.fire(coordi(i % 25, i / 25));
+				shotCount++;
+			}
+		}
+		return { "headless session", shotCount / secondsSince(start), "shots" };
+	}
+
+	vector<result_type> lookAhead(int nodes)	//Measures nodes/sec of a three-shot look-ahead on a 25x25 board, copying the board for each node and then rolling back to a snapshot instead
+	{
+		gameBoard_type board(coordi(25, 25));
+		board.generateGameBoard();
+		board.setShots(625);
+		vector<result_type> results;
+		long long shotsLeft = 0;		//Summed so the work can't be optimized away
+
+		clock_type::time_point start = clock_type::now();
+		for(int node = 0; node < nodes; node++)
+		{
+			gameBoard_type child = board;
+			for(int k = 0; k < 3; k++) child.fire(coordi((node * 7 + k * 13) % 25, (node * 3 + k) % 25));
+			shotsLeft += child.getShots();
+		}
+		results.push_back({ "look-ahead (copy board)", nodes / secondsSince(start), "nodes" });
+
+		start = clock_type::now();
+		for(int node = 0; node < nodes; node++)
+		{
+			boardSnapshot_type parent = board.snapshot();
+			for(int k = 0; k < 3; k++) board.fire(coordi((node * 7 + k * 13) % 25, (node * 3 + k) % 25));
+			shotsLeft -= board.getShots();
+			board.rollback(parent);
+		}
+		results.push_back({ "look-ahead (snapshot + rollback)", nodes / secondsSince(start), "nodes" });
+
+		if(shotsLeft != 0) cout << "look-ahead benchmark: the two searches disagree" << endl;
+		return results;
+	}
+
+	//Measures lookups/sec of one transpositionCache_type shared by one thread and by every core.  Every position of 'games' games the density shooter played is looked up
+	//'passes' times by each thread (stored on a miss), each thread starting at a different position so they fill in the cache for each other
+	vector<result_type> transpositionCaching(int games, int passes)
+	{
+		struct position_type
+		{
+			uint64_t hash;
+			uint64_t check;
+			coordi shot;	//Where the shooter fired from this position
+		};
+		vector<position_type> positions;
+
+		gameSession_type session(coordi(25, 25), 1);
+		densityShooter_type shooter;
+		for(int game = 0; game < games; game++)
+		{
+			session.reseed(game);
+			session.newGame();
+			session.getBoard().setShots(625);
+			shooter.newGame(coordi(25, 25), gameBoard_type::defaultFleet(), game);
+			while(session.getState() == running)
+			{
+				coordi at = shooter.nextShot();
+				positions.push_back({ session.getBoard().getHash(), session.getBoard().getHashCheck(), at });
+				shotResult shot = session.fire(at).value;
+				shooter.recordShot(at, shot, session.getShotLog().back().sunkLength);
+			}
+		}
+
+		transpositionCache_type<coordi> cache(positions.size() * 2);
+		vector<result_type> results;
+		vector<int> threadCounts {1};
+		if(std::thread::hardware_concurrency() > 1) threadCounts.push_back(int(std::thread::hardware_concurrency()));
+
+		for(int threads : threadCounts)
+		{
+			cache.clear();
+			std::atomic<long long> wrong(0);		//Lookups that found a different shot than the one stored for the position
+
+			clock_type::time_point start = clock_type::now();
+			vector<std::thread> workers;
+			for(int t = 0; t < threads; t++)
+			{
+				workers.push_back(std::thread([&, t]()
+				{
+					const size_t first = positions.size() * t / threads;
+					for(int pass = 0; pass < passes; pass++)
+					{
+						for(size_t i = 0; i < positions.size(); i++)
+						{
+							const position_type & position = positions[(first + i) % positions.size()];
+							coordi shot;
+							if(!cache.lookup(position.hash, position.check, shot)) cache.store(position.hash, position.check, position.shot);
+							else if(shot != position.shot) wrong++;
+						}
+					}
+				}));
+			}
+			for(auto iter = workers.begin(); iter != workers.end(); iter++)
+			{
+				iter->join();
+			}
+			results.push_back({ "transposition cache, " + util::toString(threads) + " thread(s)", double(passes) * threads * positions.size() / secondsSince(start), "lookups" });
+
+			const auto stats = cache.getStats();
+			if(stats.collisions != 0 || wrong != 0) cout << "transposition cache benchmark: " << stats.collisions << " collisions, " << wrong << " wrong shots" << endl;
+		}
+		return results;
+	}
+
+	//Measures resumes/sec of 'sessions' playerSession_types all run by one thread, as the server's --console mode runs them: each resume feeds a session one line and
+	//runs it until it needs the next.  For comparison, 'threadedSessions' sessions are each given a thread of their own, which blocks until it is its turn to feed its
+	//session, so that every resume also costs a switch between threads.  The sessions play game after game, sweeping the board row by row
+	vector<result_type> sessionMultiplexing(int sessions, int threadedSessions, int rounds)
+	{
+		vector<string> fireCommands;
+		for(int y = 0; y < 25; y++)
+		{
+			for(int x = 0; x < 25; x++)
+			{
+				fireCommands.push_back("fire " + util::columnName(x) + util::toString(y));
+			}
+		}
+
+		struct player_type
+		{
+			std::unique_ptr<playerSession_type> session;
+			size_t nextShot = 0;
+
+			void resume(const vector<string> & fireCommands)		//Types whatever the session is waiting for, and throws away what it printed
+			{
+				const playerSession_type::prompt_type prompt = session->getPrompt();
+				if(prompt == playerSession_type::prompt_menu)
+				{
+					nextShot = 0;
+					session->feed("2");		//A new game
+				}
+				else if(prompt == playerSession_type::prompt_command) session->feed(fireCommands[nextShot++ % fireCommands.size()]);
+				else session->feed("");
+				session->getOutput().clear();
+			}
+		};
+
+		auto startPlayers = [](int count)
+		{
+			vector<player_type> players(count);
+			for(auto iter = players.begin(); iter != players.end(); iter++)
+			{
+				iter->session.reset(new playerSession_type(false, false));
+				iter->session->start();
+				iter->session->getOutput().clear();
+			}
+			return players;
+		};
+
+		vector<result_type> results;
+
+		vector<player_type> players = startPlayers(sessions);
+		clock_type::time_point start = clock_type::now();
+		for(int round = 0; round < rounds; round++)
+		{
+			for(auto iter = players.begin(); iter != players.end(); iter++)
+			{
+				iter->resume(fireCommands);
+			}
+		}
+		const double multiplexed = double(rounds) * sessions / secondsSince(start);
+
+		size_t bytes = 0;
+		for(auto iter = players.begin(); iter != players.end(); iter++)
+		{
+			bytes += iter->session->getMemoryUsed();
+		}
+		results.push_back({ "player sessions, " + util::toString(sessions) + " on one thread (" + util::toString(int(bytes / 1024 / sessions)) + " KB each)", multiplexed, "resumes" });
+
+		players = startPlayers(threadedSessions);
+		std::mutex lock;
+		vector<std::condition_variable> wake(threadedSessions);		//One for each thread, so passing the turn on wakes only the thread whose turn it is
+		int turn = 0;
+
+		start = clock_type::now();
+		vector<std::thread> workers;
+		for(int t = 0; t < threadedSessions; t++)
+		{
+			workers.push_back(std::thread([&, t]()
+			{
+				for(int round = 0; round < rounds; round++)
+				{
+					std::unique_lock<std::mutex> hold(lock);
+					wake[t].wait(hold, [&]() { return turn == t; });
+					players[t].resume(fireCommands);
+					turn = (t + 1) % threadedSessions;
+					wake[turn].notify_one();
+				}
+			}));
+		}
+		for(auto iter = workers.begin(); iter != workers.end(); iter++)
+		{
+			iter->join();
+		}
+		const double threaded = double(rounds) * threadedSessions / secondsSince(start);
+		results.push_back({ "player sessions, " + util::toString(threadedSessions) + " on a thread each", threaded, "resumes" });
+
+		if(threaded < multiplexed) results.push_back({ "player sessions, thread switch (the difference)", 1 / (1 / threaded - 1 / multiplexed), "switches" });
+		return results;
+	}
+
+	vector<result_type> tournamentScaling(int boards)		//Measures games/sec of runTournament() with the random and hunt shooters, on one thread and on every core
+	{
+		vector<result_type> results;
+		vector<int> threadCounts {1};
+		if(std::thread::hardware_concurrency() > 1) threadCounts.push_back(int(std::thread::hardware_concurrency()));
+
+		for(int threads : threadCounts)
+		{
+			tournamentResult_type tournament = runTournament({ "random", "hunt" }, boards, 1, threads);
+			results.push_back({ "tournament, " + util::toString(threads) + " thread(s) (" + util::toString(int(tournament.steals)) + " tasks stolen)", 2.0 * boards / tournament.seconds, "games" });
+		}
+		return results;
+	}
+
+	vector<result_type> frameComposition(int frames)	//Measures frames/sec and bytes/frame of screenBuffer_type, for a full redraw and for a frame where one shot changed
+	{
+		screenBuffer_type buffer;
+		buffer.setSize(coordi(77, 30));
+		for(int y = 0; y < 30; y++)
+		{
+			buffer.write(coordi(0, y), string(77, char('a' + y % 26)));
+		}
+
+		vector<result_type> results;
+		string frame;
+		size_t bytes = 0;
+
+		clock_type::time_point start = clock_type::now();
+		for(int i = 0; i < frames; i++)
+		{
+			frame.clear();
+			buffer.invalidate();
+			buffer.composeFrame(frame);
+			bytes += frame.size();
+		}
+		double seconds = secondsSince(start);
+		results.push_back({ "frame composition (full redraw, " + util::toString(int(bytes / frames)) + " bytes/frame)", frames / seconds, "frames" });
+
+		bytes = 0;
+		start = clock_type::now();
+		for(int i = 0; i < frames; i++)
+		{
+			//A shot changes one board cell, the shots remaining, and the feedback line
+			buffer.write(coordi(3 + (i % 25) * 2, 2 + (i / 25) % 25), (i % 2) ? 'M' : 'H');
+			buffer.write(coordi(56, 17), util::toString(i % 60) + " ");
+			buffer.clearRow(28);
+			buffer.write(coordi(0, 28), (i % 2) ? "We didn't hit anything Admiral." : "Confirmed hit Admiral!");
+
+			frame.clear();
+			buffer.composeFrame(frame);
+			bytes += frame.size();
+		}
+		seconds = secondsSince(start);
+		results.push_back({ "frame composition (one shot, " + util::toString(int(bytes / frames)) + " bytes/frame)", frames / seconds, "frames" });
+
+		return results;
+	}
+
+	vector<cellContents_type> extractCellsFromString(string str)	//Extracts data from 'str' and converts it to a vector of 'cellContents_type' elements.  Ignores spaces.
+	{
+		vector<cellContents_type> data;
+		for(auto iter = str.begin(); iter != str.end(); iter++)
+		{
+			if(*iter != ' ') data.push_back(utilities::toCellType(*iter));
+		}
+		return data;
+	}
+
+	//The loader gameBoard_type used before loadFromMemory(): getline, a vector of cells per line, then one cell at a time.  Returns the errors it recovered from.
+	vector<errorstates> legacyLoad(gameBoard_type & board, ifstream & file)
+	{
+		vector<errorstates> errors;
+		coordi size = board.getBoardSize();
+
+		for(int y = 0; y < size.y; y++)
+		{
+			string line;
+			getline(file, line);
+
+			if(!file.eof() || y == (size.y - 1))
+			{
+				vector<cellContents_type> row = extractCellsFromString(line);
+
+				if(row.size() > size_t(size.x)) errors.push_back(file_lineTooLong);
+				else if(row.size() < size_t(size.x)) errors.push_back(file_lineTooShort);
+
+				for(int x = 0; x < size.x; x++)
+				{
+					if(size_t(x) < row.size()) board.setContents(coordi(x, y), row[x]);
+					else
+					{
+						errors.push_back(file_lineTooShort);
+						board.setContents(coordi(x, y), ocean);
+					}
+				}
+			}
+			else
+			{
+				errors.push_back(file_eof);
+				for(int x = 0; x < size.x; x++)
+				{
+					board.setContents(coordi(x, y), ocean);
+				}
+			}
+		}
+		return errors;
+	}
+
+	string writeSyntheticLevel(coordi size)		//Writes a random level file of 'size' to a temporary file, and returns its name
+	{
+		string filename = "benchmark_level.tmp";
+		std::ofstream file(filename, std::ios::binary);
+		random_type random(size.x * 31 + size.y);
+		const char tokens[] = { '~', '~', '~', '~', '#', 'H', 'M' };
+
+		string line;
+		for(int y = 0; y < size.y; y++)
+		{
+			line.clear();
+			for(int x = 0; x < size.x; x++)
+			{
+				line += tokens[random.below(sizeof(tokens))];
+				line += ' ';
+			}
+			line.back() = '\n';
+			file << line;
+		}
+		return filename;
+	}
+
+	//Measures MB/sec of loadFromFile() against the old getline loader, on a synthetic level of 'size', and cells/sec of the ship labeling that is part of it.  The old
+	//loader didn't look for ships, so the ship labeling is run after it as well, so both rows time the same work
+	vector<result_type> levelLoading(coordi size, int loads)
+	{
+		string filename = writeSyntheticLevel(size);
+		const double megabytes = double(size.x) * 2 * size.y / (1024 * 1024);
+		const string label = " " + util::toString(size.x) + "x" + util::toString(size.y);
+
+		gameBoard_type board(size);
+		vector<result_type> results;
+		{
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < loads; i++)
+			{
+				ifstream file(filename);
+				legacyLoad(board, file);
+				board.identifyShips();
+			}
+			results.push_back({ "level loading (getline)" + label, loads * megabytes / secondsSince(start), "MB" });
+		}
+		{
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < loads; i++)
+			{
+				board.loadFromFile(filename);
+			}
+			results.push_back({ "level loading (memory mapped)" + label, loads * megabytes / secondsSince(start), "MB" });
+		}
+
+		//The ship labeling pass on its own (it's part of every load above), on one thread and then on every core
+		bitBoard_type cells;
+		cells.resize(size);
+		for(int y = 0; y < size.y; y++)
+		{
+			for(int x = 0; x < size.x; x++)
+			{
+				cells.setCell(x, y, board.getContentsUnchecked(coordi(x, y)));
+			}
+		}
+		for(int threads : { 1, 0 })
+		{
+			vector<shipRecord_type> ships;
+			vector<shipProblem_type> problems;
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < loads; i++)
+			{
+				ships.clear();
+				problems.clear();
+				shipLabeler_type::label(cells, ships, problems, threads);
+			}
+			results.push_back({ "ship labeling" + label + (threads == 1 ? ", 1 thread" : ", every core"), double(loads) * size.x * size.y / secondsSince(start), "cells" });
+		}
+
+		std::remove(filename.c_str());
+		return results;
+	}
+
+	string toLower(string input)	//Converts input to lowercase
+	{
+		for(int i = 0; i < int(input.size()); i++)
+		{
+			input[i] = tolower(input[i]);
+		}
+		return input;
+	}
+
+	vector<string> separateStringsBySpaces(string str)		//Separates a string into a vector of strings, using spaces as separators (i.e. "A B C" -> {a,b,c})
+	{
+		vector<string> ret;	//The extracted data
+
+		string data = "";	//The current segment of data
+
+		for(auto iter = str.begin(); iter != str.end(); iter++)	//Loop over every element in the string
+		{
+			if(*iter == ' ')	//If the character reached is a space, move the current segment to the extracted data array, and reset the extracted data string
+			{
+				ret.push_back(data);
+				data = "";
+			}
+			else data.push_back(*iter);
+		}
+		if(data != "") ret.push_back(data);	//If the data we have itsn't none, add it to the extracted data vector
+		
+		return ret;
+	}
+
+	double legacyToNum(string inp)	//The string to number conversion the command parser used before parseInt(), which threw on failure
+	{
+		double ret;
+
+		std::stringstream convert;
+		convert << inp;
+		convert >> ret;
+
+		if(convert.fail()) throw convert_fail_strInt;
+
+		return ret;
+	}
+
+	bool legacyIsNum(string inp)		//The number check that went with legacyToNum(), which worked by catching its exception
+	{
+		try
+		{
+			legacyToNum(inp);
+		}
+		catch(...)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	//The command parsing mainLoop() used before tokenize(): a lowercased copy, a vector of words, and stringstream conversions.  Returns the coordinate fired at, or (-1, -1)
+	coordi legacyParseCommand(const string & input)
+	{
+		vector<string> command = separateStringsBySpaces(toLower(input));
+		if(command.size() < 2 || command[0] != "fire" || command[1].size() < 2) return coordi(-1, -1);
+
+		char first = command[1][0];
+		string second = command[1].substr(1);
+		if(!utilities::isCharLetter(first) || !legacyIsNum(second)) return coordi(-1, -1);
+
+		return coordi(toupper(first) - 'A', int(legacyToNum(second)));
+	}
+
+	vector<result_type> commandParsing(int commands)		//Measures commands/sec of splitting a command and reading its firing coordinate, before and after tokenize()
+	{
+		const string lines[] = { "fire b12", "FIRE A3", "fire  z99", "fire k7 now", "#setshots 40", "fire q", "fire 12", "Fire Y24" };
+		const int lineCount = int(sizeof(lines) / sizeof(lines[0]));
+
+		vector<result_type> results;
+		{
+			volatile int sink = 0;
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < commands; i++)
+			{
+				coordi at = legacyParseCommand(lines[i % lineCount]);
+				sink = sink + at.x + at.y;
+			}
+			results.push_back({ "command parsing (stringstream)", commands / secondsSince(start), "commands" });
+		}
+		{
+			volatile int sink = 0;
+			string input;
+			utilities::commandTokens_type command;
+
+			clock_type::time_point start = clock_type::now();
+			for(int i = 0; i < commands; i++)
+			{
+				input.assign(lines[i % lineCount]);		//Reuses the storage, the way mainLoop() does
+				utilities::toLowerInPlace(input);
+				utilities::tokenize(input, command);
+
+				coordi at(-1, -1);
+				if(command.size() >= 2 && command[0] == "fire") utilities::parseCoordinate(command[1], at);
+				sink = sink + at.x + at.y;
+			}
+			results.push_back({ "command parsing (string_view)", commands / secondsSince(start), "commands" });
+		}
+		return results;
+	}
+
+	//Measures shots/sec with and without a journal attached, and how fast a journal can be indexed and every game in it replayed to its end.  Every game has its
+	//shots 101 to 110 undone partway through, and then fired again, so the replays check that the journal's turns are taken back too
+	vector<result_type> journaling(int games)
+	{
+		const string filename = "benchmark_journal.tmp";
+		std::remove(filename.c_str());
+
+		vector<result_type> results;
+		vector<std::pair<uint64_t, int>> endings;		//The hash and shots left of each recorded game's board when it ended, to check the replays against
+		for(int recorded = 0; recorded < 2; recorded++)
+		{
+			journal_type journal;
+			gameSession_type session(coordi(25, 25), 1);
+			if(recorded)
+			{
+				journal.open(filename);
+				session.getBoard().setJournal(&journal);
+			}
+
+			long long shotCount = 0;
+			clock_type::time_point start = clock_type::now();
+			for(int game = 0; game < games; game++)
+			{
+				session.newGame();
+				session.getBoard().setShots(625);
+				boardSnapshot_type undoTo;
+				bool undone = false;
+				for(int i = 0; session.getState() == running; i++)
+				{
+					if(i == 100 && !undone) undoTo = session.getBoard().snapshot();
+					if(i == 110 && !undone)
+					{
+						session.getBoard().rollback(undoTo);
+						undone = true;
+						i = 100;
+					}
+					session.fire(coordi(i % 25, i / 25));
+					shotCount++;
+				}
+				if(recorded) endings.push_back({ session.getBoard().getHash(), session.getBoard().getShots() });
+			}
+			journal.close();
+			results.push_back({ string("headless session (") + (recorded ? "journal" : "no journal") + ")", shotCount / secondsSince(start), "shots" });
+		}
+
+		{
+			double megabytes = 0;
+			gameBoard_type board(coordi(25, 25));
+
+			clock_type::time_point start = clock_type::now();
+			journalReader_type reader(filename);
+			int wrong = 0;		//Games that didn't replay to the board they ended with
+			for(int game = 0; game < reader.getGameCount(); game++)
+			{
+				reader.seek(game, reader.getTurnCount(game), board);
+				if(size_t(game) >= endings.size() || board.getHash() != endings[game].first || board.getShots() != endings[game].second) wrong++;
+				else if(reader.getTurnCount(game) != 625 - endings[game].second) wrong++;		//Every shot left in the game is a turn, and none of those undone are
+			}
+			if(wrong != 0 || reader.getGameCount() != games) cout << "journal benchmark: " << wrong << " games replayed wrongly, " << reader.getGameCount() << " of " << games << " games found" << endl;
+			{
+				mappedFile_type file(filename);
+				megabytes = double(file.size()) / (1024 * 1024);
+			}
+			results.push_back({ "journal index + seek to the end of every game", megabytes / secondsSince(start), "MB" });
+		}
+
+		std::remove(filename.c_str());
+		return results;
+	}
+
+	result_type scriptReplay(int games)		//Measures games/sec of runScriptBatch(), with a script that sweeps the board row by row
+	{
+		string text = "#setshots 625\n";
+		for(int y = 0; y < 25; y++)
+		{
+			for(int x = 0; x < 25; x++)
+			{
+				text += "fire " + string(1, char('a' + x)) + util::toString(y) + "\n";
+			}
+		}
 
-			if(debug_forceRun && debugCommandsOn) gameState = running;
+		commandScript_type script;
+		parseCommandScript(text.data(), text.size(), script);
 
-			switch(gameState)
+		gameSession_type session(coordi(25, 25));
+		scriptBatchResult_type result = runScriptBatch(script, session, games, nullptr, 1);
+		return { "script replay", games / result.seconds, "games" };
+	}
+
+	vector<result_type> runSuite(int scale = 1)		//Runs every benchmark and returns the results.  The number of repetitions is divided by 'scale', for a quicker (but noisier) run
+	{
+		auto reps = [scale](int count) { return std::max(1, count / scale); };
+
+		vector<result_type> results = boardStorage(coordi(25, 25), reps(20000));
+		vector<result_type> large = boardStorage(coordi(1000, 1000), reps(10));
+		results.insert(results.end(), large.begin(), large.end());
+
+		vector<result_type> generation = boardGeneration(coordi(25, 25), gameBoard_type::defaultFleet(), reps(20000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		//A crowded board: 16 ships of length 4 on 10x10, where the old generator spends most of its time retrying
+		generation = boardGeneration(coordi(10, 10), vector<int>(16, 4), reps(200));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		generation = batchGeneration(reps(100000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		generation = boardFiring(coordi(25, 25), reps(20000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		results.push_back(headlessShots(reps(20000)));
+
+		generation = tournamentScaling(reps(20000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		generation = lookAhead(reps(200000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		generation = transpositionCaching(200, reps(200));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		generation = sessionMultiplexing(1000, 64, reps(100));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		results.push_back(posteriorSolving(120, reps(100)));
+		results.push_back(posteriorSolving(90, reps(5)));
+		results.push_back(posteriorEstimating(3, 90, reps(20)));
+		results.push_back(posteriorEstimating(1, 90, reps(5)));
+		results.push_back(posteriorCrossCheck(reps(200)));
+
+		generation = frameComposition(reps(20000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		generation = levelLoading(coordi(2000, 2000), reps(5));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		generation = commandParsing(reps(1000000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		results.push_back(scriptReplay(reps(20000)));
+
+		generation = journaling(reps(5000));
+		results.insert(results.end(), generation.begin(), generation.end());
+
+		return results;
+	}
+
+	void runAll(std::ostream & out)		//Runs every benchmark and prints the results to 'out'
+	{
+		out << "Running benchmarks..." << endl;
+
+		vector<result_type> results = runSuite();
+		for(auto iter = results.begin(); iter != results.end(); iter++)
+		{
+			printResult(*iter, out);
+		}
+
+		for(string name : { "random", "hunt", "density" })
+		{
+			runShooterBatch(*makeShooter(name), 2000, 1).print(out);
+		}
+	}
+};
+
+//Server mode: Battleship --serve <port | socket path> [--seed <number>] [--console]
+//Hosts any number of games at once, one per connection, on a TCP port (on 127.0.0.1) or a Unix socket.  Every connection starts with a new random board.
+//With --console, each connection gets the whole console game instead (title menu, screen and all, for a terminal on the other end, with debug commands and loading boards from files off), run by a
+//playerSession_type that the server resumes whenever a line arrives for it.  Otherwise commands are lines of text, and each one is answered with one line:
+//	fire <letter><number>	->	"hit", "hit sunk <length>", "miss" or "already fired", then the game's state ("running", "win" or "lose").  "invalid coordinate" or "game over" if it didn't fire
+//	new						->	"new game <shots>", on a new random board
+//	shots					->	"shots <shots remaining>"
+//	quit					->	closes the connection
+//Anything else is answered with "unknown command".
+
+const char * gameStateName(gameState_type state)		//The word the server uses for 'state'
+{
+	switch(state)
+	{
+		case running: return "running";
+		case win: return "win";
+		case lose: return "lose";
+		default: return "no game";
+	}
+}
+
+bool serveCommand(gameSession_type & session, string & line, string & reply)	//Runs the server command in 'line' (lowercased in place) and appends the answer and a newline to 'reply'.  Returns false if the connection should be closed
+{
+	utilities::toLowerInPlace(line);
+	utilities::commandTokens_type command;
+	utilities::tokenize(line, command);
+
+	if(command.size() == 0)
+	{
+		reply += "unknown command\n";
+	}
+	else if(command[0] == "fire")
+	{
+		coordi at;
+		if(command.size() < 2 || !utilities::parseCoordinate(command[1], at))
+		{
+			reply += "invalid coordinate\n";
+			return true;
+		}
+
+		outcome_type<shotResult> shot = session.fire(at);
+		if(!shot.ok() || shot.value == noAmmo)
+		{
+			reply += (shot.ok() ? "game over\n" : "invalid coordinate\n");
+			return true;
+		}
+
+		if(shot.value == alreadyFired) reply += "already fired";
+		else if(shot.value == miss) reply += "miss";
+		else
+		{
+			const shipRecord_type * sunk = session.getBoard().getLastSunkShip();
+			reply += "hit";
+			if(sunk != nullptr)
+			{
+				reply += " sunk ";
+				reply += utilities::toString(sunk->length);
+			}
+		}
+		reply += ' ';
+		reply += gameStateName(session.getState());
+		reply += '\n';
+	}
+	else if(command[0] == "new")
+	{
+		if(session.newGame()) reply += "new game " + utilities::toString(session.getBoard().getShots()) + "\n";
+		else reply += utilities::errorStateToString(board_gen_noRoom) + "\n";
+	}
+	else if(command[0] == "shots")
+	{
+		reply += "shots " + utilities::toString(session.getBoard().getShots()) + "\n";
+	}
+	else if(command[0] == "quit")
+	{
+		return false;
+	}
+	else reply += "unknown command\n";
+
+	return true;
+}
+
+#ifdef __linux__
+
+int openSocket(const string & address, bool listening)		//Opens a TCP socket on 127.0.0.1 if 'address' is a port number, or a Unix socket at the path 'address' if it isn't,
+{															//and listens on it or connects it.  Returns the socket, or -1 (with errno set) if it couldn't be opened
+	int port = 0;
+	const bool tcp = utilities::parseInt(address, port);
+
+	int socket = ::socket(tcp ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(socket < 0) return -1;
+
+	int result;
+	if(tcp)
+	{
+		sockaddr_in where = {};
+		where.sin_family = AF_INET;
+		where.sin_port = htons(uint16_t(port));
+		where.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		int on = 1;
+		setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));		//Replies are tiny, and waiting to batch them up would cost milliseconds
+		if(listening) setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+		result = (listening ? ::bind(socket, (sockaddr *) &where, sizeof(where)) : ::connect(socket, (sockaddr *) &where, sizeof(where)));
+	}
+	else
+	{
+		sockaddr_un where = {};
+		where.sun_family = AF_UNIX;
+		if(address.size() >= sizeof(where.sun_path))
+		{
+			::close(socket);
+			errno = ENAMETOOLONG;
+			return -1;
+		}
+		std::memcpy(where.sun_path, address.data(), address.size());
+
+		if(listening) ::unlink(address.c_str());		//A socket file left behind by an earlier server
+		result = (listening ? ::bind(socket, (sockaddr *) &where, sizeof(where)) : ::connect(socket, (sockaddr *) &where, sizeof(where)));
+	}
+
+	if(result == 0 && listening) result = ::listen(socket, SOMAXCONN);
+	if(result != 0)
+	{
+		const int error = errno;
+		::close(socket);
+		errno = error;
+		return -1;
+	}
+
+	fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+	return socket;
+}
+
+class gameServer_type		//Runs a game for every connection to one socket, all on one thread, using epoll to wait for whichever connections have something to do
+{
+	struct connection_type
+	{
+		int socket;
+		gameSession_type session;
+		string input;		//Received, but not a whole line yet
+		string output;		//Replies not sent yet
+		size_t sent = 0;	//How much of 'output' has been sent
+		bool writing = false;	//True while epoll is watching for room to send the rest of 'output'
+		std::unique_ptr<playerSession_type> player;		//The console game, in --console mode (nullptr otherwise)
+
+		connection_type(int _socket, uint64_t seed) : socket(_socket), session(coordi(25, 25), seed) {}
+	};
+
+	static const size_t maxLineLength = 4096;		//A connection that sends more than this without a newline is closed, rather than buffered without end
+
+	int listener = -1;
+	int events = -1;		//The epoll instance
+	int spare = -1;			//A descriptor held in reserve: when the process runs out of them, it is closed to accept (and drop) a waiting connection, which would otherwise keep epoll waking up
+	bool listening = true;	//False while accepting is paused, because there were no descriptors left and no spare to free
+	vector<std::unique_ptr<connection_type>> connections;		//Indexed by socket, which the OS keeps small and dense
+	uint64_t seedState;
+	const bool console;		//True to run a console game on every connection, rather than answering commands
+	string line;			//The command being run, kept so running one doesn't allocate
+
+	void setListening(bool on)		//Starts or stops epoll reporting new connections
+	{
+		listening = on;
+
+		epoll_event event = {};
+		event.events = (on ? uint32_t(EPOLLIN) : 0u);
+		event.data.fd = listener;
+		epoll_ctl(events, EPOLL_CTL_MOD, listener, &event);
+	}
+
+	void accept()		//Accepts every waiting connection, and starts a game for each
+	{
+		while(true)
+		{
+			int socket = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if(socket < 0 && (errno == EMFILE || errno == ENFILE))
 			{
-				case running:
+				if(spare < 0)		//Nothing to free, so stop accepting until a connection closes
 				{
-					if(handleDebugCommands(command))
-					{
-						//Do nothing because the command was already handled
-					}
-					else if(command.size() == 0)
-					{
-						//The user typed nothing
-					}
-					else if(command[0] == "fire")
-					{
-						if(gameState != running)
-						{
-							printPlayerFeedback("This command cannot be used at this time.");
-						}
-						else
-						{
-							if(command.size() < 2)
-							{
-								printPlayerFeedback("Please specify a firing coordinate.");
-								return;
-							}
-							else
-							{
-								string pos = command[1];
-
-								if(pos.size() >= 2) //If the command is at least two characters long
-								{
-									char first = pos[0];
-									string second = pos.substr(1);
-
-									if(!utilities::isCharLetter(first) || !utilities::isNum(second))		//If either part of the coordinate is invalid (if the first character is not a letter, and if the remaining text is not a number
-									{
-
-										printPlayerFeedback("Sorry Admiral, firing coordinate \"" + pos + "\" is invalid.  Please try again.");
-										return;
-									}
-									else
-									{
-										try
-										{
-											shotResult result = gameBoard.fire(first, utilities::toNum(second));
-
-											gameBoard.checkWinLoss();
-
-											if(result == shotResult::alreadyFired)
-											{
-												printPlayerFeedback("You already fired on that location.");
-											}
-											else if(result == shotResult::hit)
-											{
-												printPlayerFeedback("Confirmed hit Admiral!");
-											}
-											else if(result == shotResult::miss)
-											{
-												printPlayerFeedback("We didn't hit anything Admiral.");
-											}
-										}
-										catch(errorstates err)
-										{
-											if(err == board_badX || err == board_badY)	//If the user fired at an invalid point
-											{
-												printPlayerFeedback("Sorry Admiral, firing coordinate \"" + pos + "\" is invalid.  Please try again.");
-											}
-											else throw err;		//If we can't handle it here, just pass it up the 'chain'
-										};
-									}
-								}
-								else
-								{
-									printPlayerFeedback("Sorry Admiral, firing coordinate \"" + pos + "\" is invalid.  Please try again.");
-									return;
-								}
-							}
+					setListening(false);
+					return;
+				}
 
-						}
+				::close(spare);		//Frees one descriptor to turn the connection away with
+				socket = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+				if(socket >= 0) ::close(socket);
+				spare = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+				if(socket < 0) return;		//None left to turn away (accept4() reports running out of descriptors whether or not a connection is waiting)
+				continue;
+			}
+			if(socket < 0)
+			{
+				if(errno == ECONNABORTED || errno == EINTR) continue;
+				return;		//None left
+			}
 
+			int on = 1;
+			setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));		//Fails harmlessly on Unix sockets
 
-					}
+			if(connections.size() <= size_t(socket)) connections.resize(size_t(socket) + 1);
+			connection_type & connection = *(connections[socket] = std::unique_ptr<connection_type>(new connection_type(socket, utilities::splitMix64(seedState))));
+
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.fd = socket;
+			epoll_ctl(events, EPOLL_CTL_ADD, socket, &event);
+
+			if(!console)
+			{
+				connection.session.newGame();
+				continue;
+			}
+
+			connection.player.reset(new playerSession_type(false, false));
+			connection.player->start();
+			takeOutput(connection);
+			if(!send(connection)) close(connection);
+		}
+	}
+
+	void takeOutput(connection_type & connection)		//Moves what the connection's console game has printed to the connection's output
+	{
+		string & printed = connection.player->getOutput();
+		connection.output += printed;
+		printed.clear();
+	}
+
+	void close(connection_type & connection)
+	{
+		const int socket = connection.socket;
+		epoll_ctl(events, EPOLL_CTL_DEL, socket, nullptr);
+		::close(socket);
+		connections[socket].reset();
+
+		if(!listening) setListening(true);		//There's a descriptor free now
+	}
+
+	//Sends as much of the connection's output as the socket will take, and has epoll say when there's room for the rest.  Nothing more is read from the connection
+	//until all of it has been sent, so a client that doesn't read its replies can't make them pile up.  Returns false if the connection is broken
+	bool send(connection_type & connection)
+	{
+		while(connection.sent < connection.output.size())
+		{
+			ssize_t written = ::send(connection.socket, connection.output.data() + connection.sent, connection.output.size() - connection.sent, MSG_NOSIGNAL);
+			if(written < 0)
+			{
+				if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+				return false;
+			}
+			connection.sent += size_t(written);
+		}
+
+		const bool pending = (connection.sent < connection.output.size());
+		if(!pending)
+		{
+			connection.output.clear();
+			connection.sent = 0;
+		}
+		if(pending != connection.writing)
+		{
+			connection.writing = pending;
+
+			epoll_event event = {};
+			event.events = (pending ? uint32_t(EPOLLOUT) : uint32_t(EPOLLIN));
+			event.data.fd = connection.socket;
+			epoll_ctl(events, EPOLL_CTL_MOD, connection.socket, &event);
+		}
+		return true;
+	}
+
+	bool receive(connection_type & connection)		//Reads what has arrived, runs every whole command in it, and sends the replies.  Returns false if the connection should be closed
+	{
+		char buffer[16384];
+		ssize_t length = ::recv(connection.socket, buffer, sizeof(buffer), 0);
+		if(length == 0) return false;		//The other end hung up
+		if(length < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+		connection.input.append(buffer, size_t(length));
+
+		size_t start = 0;
+		while(true)
+		{
+			size_t newline = connection.input.find('\n', start);
+			if(newline == string::npos) break;
 
+			line.assign(connection.input, start, newline - start);
+			if(!line.empty() && line.back() == '\r') line.pop_back();
+			start = newline + 1;
+
+			if(connection.player != nullptr)
+			{
+				connection.player->feed(line);
+				takeOutput(connection);
+				if(connection.player->isFinished())
+				{
+					send(connection);		//The goodbye
+					return false;
 				}
-					break;
+			}
+			else if(!serveCommand(connection.session, line, connection.output))
+			{
+				send(connection);		//Whatever was answered before the quit
+				return false;
+			}
+		}
+		connection.input.erase(0, start);
+		if(connection.input.size() > maxLineLength) return false;
 
-				case lose:
-					lossScreen();
-					break;
+		return send(connection);
+	}
 
-				case win:
-					winScreen();
-					break;
+public:
+	gameServer_type(uint64_t seed, bool _console) : seedState(seed), console(_console) {}
+
+	~gameServer_type()
+	{
+		for(size_t i = 0; i < connections.size(); i++)
+		{
+			if(connections[i] != nullptr) ::close(connections[i]->socket);
+		}
+		if(events >= 0) ::close(events);
+		if(listener >= 0) ::close(listener);
+		if(spare >= 0) ::close(spare);
+	}
+
+	bool open(const string & address)		//Starts listening on 'address' (see openSocket()).  Returns false, with errno set, if it can't
+	{
+		listener = openSocket(address, true);
+		if(listener < 0) return false;
+		spare = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+		events = epoll_create1(EPOLL_CLOEXEC);
+		if(events < 0) return false;
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = listener;
+		return epoll_ctl(events, EPOLL_CTL_ADD, listener, &event) == 0;
+	}
+
+	void run()		//Serves connections until the process is stopped
+	{
+		epoll_event ready[256];
+		while(true)
+		{
+			int count = epoll_wait(events, ready, 256, -1);
+			for(int i = 0; i < count; i++)
+			{
+				const int socket = ready[i].data.fd;
+				if(socket == listener)
+				{
+					accept();
+					continue;
+				}
+
+				connection_type * connection = (size_t(socket) < connections.size() ? connections[socket].get() : nullptr);
+				if(connection == nullptr) continue;
+
+				bool open = true;
+				if(ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) open = receive(*connection);
+				if(open && (ready[i].events & EPOLLOUT)) open = send(*connection);
+				if(!open) close(*connection);
+			}
+		}
+	}
+};
+
+#endif
+
+int runServerMode(int argc, char * argv[])		//See the server mode notes above.  Returns the program's exit code
+{
+	string address;
+	int seed = 1;
+	bool console = false;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const std::string_view option = argv[i];
+		const bool hasValue = (i + 1 < argc);
+
+		if(option == "--serve" && hasValue) address = argv[++i];
+		else if(option == "--seed" && hasValue && utilities::parseInt(argv[i + 1], seed)) i++;
+		else if(option == "--console") console = true;
+		else
+		{
+			cout << "Usage: " << argv[0] << " --serve <port | socket path> [--seed <number>] [--console]" << endl;
+			return 1;
+		}
+	}
+
+#ifdef __linux__
+	util::seedRandom((uint64_t) seed);		//Console games generate their boards from the shared randomizer
+	gameServer_type server((uint64_t) seed, console);
+	if(!server.open(address))
+	{
+		cout << "Could not listen on \"" << address << "\": " << std::strerror(errno) << endl;
+		return 1;
+	}
+
+	cout << "Serving games on " << address << endl;
+	server.run();
+	return 0;
+#else
+	cout << "Server mode needs epoll, so it only runs on Linux." << endl;
+	return 1;
+#endif
+}
+
+//Load test: Battleship --loadtest <port | socket path> [--clients <number>] [--commands <number>]
+//Opens 'clients' connections to a server and has each one play through 'commands' commands, one at a time, sweeping its board row by row and starting a new game
+//whenever one ends.  Prints the commands/sec and the time from sending a command to getting its answer.  Returns the program's exit code
+int runLoadTest(int argc, char * argv[])
+{
+	string address;
+	int clientCount = 100;
+	int commandsEach = 10000;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const std::string_view option = argv[i];
+		const bool hasValue = (i + 1 < argc);
+
+		if(option == "--loadtest" && hasValue) address = argv[++i];
+		else if(option == "--clients" && hasValue && utilities::parseInt(argv[i + 1], clientCount) && clientCount > 0) i++;
+		else if(option == "--commands" && hasValue && utilities::parseInt(argv[i + 1], commandsEach) && commandsEach > 0) i++;
+		else
+		{
+			cout << "Usage: " << argv[0] << " --loadtest <port | socket path> [--clients <number>] [--commands <number>]" << endl;
+			return 1;
+		}
+	}
+
+#ifdef __linux__
+	typedef std::chrono::steady_clock clock_type;
+
+	struct client_type
+	{
+		int socket = -1;
+		int shot = 0;				//The next cell to fire at, counted row by row
+		int commandsLeft = 0;
+		string input;
+		clock_type::time_point sentAt;
+	};
+
+	int events = epoll_create1(EPOLL_CLOEXEC);
+	vector<client_type> clients(clientCount);
+	for(int i = 0; i < clientCount; i++)
+	{
+		clients[i].socket = openSocket(address, false);
+		if(clients[i].socket < 0)
+		{
+			cout << "Connection " << i + 1 << " to \"" << address << "\" failed: " << std::strerror(errno) << endl;
+			for(int j = 0; j < i; j++) ::close(clients[j].socket);
+			::close(events);
+			return 1;
+		}
+		clients[i].commandsLeft = commandsEach;
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u32 = uint32_t(i);
+		epoll_ctl(events, EPOLL_CTL_ADD, clients[i].socket, &event);
+	}
+
+	auto sendNext = [](client_type & client, bool newGame)		//Sends the client's next command.  Commands are tiny and only one is ever waiting, so the send can't block
+	{
+		char command[32];
+		int length;
+		if(newGame)
+		{
+			client.shot = 0;
+			length = snprintf(command, sizeof(command), "new\n");
+		}
+		else
+		{
+			length = snprintf(command, sizeof(command), "fire %c%d\n", char('a' + client.shot % 25), client.shot / 25);
+			client.shot++;
+		}
+		client.sentAt = clock_type::now();
+		return ::send(client.socket, command, size_t(length), MSG_NOSIGNAL) == length;
+	};
+
+	profiling::histogram_type latency;
+	int active = clientCount;
+	bool failed = false;
+	clock_type::time_point start = clock_type::now();
+	for(int i = 0; i < clientCount; i++) sendNext(clients[i], false);
+
+	epoll_event ready[256];
+	while(active > 0 && !failed)
+	{
+		int count = epoll_wait(events, ready, 256, -1);
+		for(int i = 0; i < count; i++)
+		{
+			client_type & client = clients[ready[i].data.u32];
+
+			char buffer[4096];
+			ssize_t length = ::recv(client.socket, buffer, sizeof(buffer), 0);
+			if(length <= 0)
+			{
+				if(length < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+				cout << "The server closed a connection." << endl;
+				failed = true;
+				break;
+			}
+			client.input.append(buffer, size_t(length));
+
+			size_t newline = client.input.find('\n');
+			if(newline == string::npos) continue;		//Only part of the answer has arrived
+
+			latency.record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - client.sentAt).count()));
+			const std::string_view answer(client.input.data(), newline);
+			const std::string_view state = answer.substr(answer.rfind(' ') + 1);		//The last word of a shot's answer is the game's state
+			const bool gameOver = (state == "win" || state == "lose" || state == "over");
+			const bool newGame = gameOver || client.shot >= 25 * 25;
+			client.input.erase(0, newline + 1);
+
+			if(--client.commandsLeft == 0)
+			{
+				epoll_ctl(events, EPOLL_CTL_DEL, client.socket, nullptr);
+				active--;
+			}
+			else if(!sendNext(client, newGame))
+			{
+				cout << "A command could not be sent." << endl;
+				failed = true;
+				break;
 			}
 		}
 	}
+	const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	for(int i = 0; i < clientCount; i++) ::close(clients[i].socket);
+	::close(events);
+	if(failed) return 1;
+
+	cout << clientCount << " clients, " << latency.getCount() << " commands in " << seconds << " seconds: " << std::fixed << latency.getCount() / seconds << " commands/sec" << endl;
+	char line[128];
+	snprintf(line, sizeof(line), "latency (us): mean %.2f, p50 %.2f, p99 %.2f, max %.2f", latency.mean() / 1000, latency.percentile(0.5) / 1000.0,
+		latency.percentile(0.99) / 1000.0, latency.getLongest() / 1000.0);
+	cout << line << endl;
+	return 0;
+#else
+	cout << "The load test needs epoll, so it only runs on Linux." << endl;
+	return 1;
+#endif
+}
+
+//Benchmark mode: Battleship --benchmark [--format <tsv|json>] [--quick] [--output <file>]
+//Runs every benchmark without using the console, and writes the results in a form a script can compare between runs.  Returns the program's exit code
+int runBenchmarkMode(int argc, char * argv[])
+{
+	bool json = false;
+	int scale = 1;
+	string outputFile;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const std::string_view option = argv[i];
+		const bool hasValue = (i + 1 < argc);
+
+		if(option == "--benchmark") continue;
+		else if(option == "--format" && hasValue && (argv[i + 1] == std::string_view("tsv") || argv[i + 1] == std::string_view("json"))) json = (argv[++i] == std::string_view("json"));
+		else if(option == "--quick") scale = 20;
+		else if(option == "--output" && hasValue) outputFile = argv[++i];
+		else
+		{
+			cout << "Usage: " << argv[0] << " --benchmark [--format <tsv|json>] [--quick] [--output <file>]" << endl;
+			return 1;
+		}
+	}
+
+	vector<benchmarks::result_type> results = benchmarks::runSuite(scale);
+
+	if(outputFile.empty())
+	{
+		benchmarks::writeResults(results, json, cout);
+		return 0;
+	}
+
+	std::ofstream file(outputFile);
+	benchmarks::writeResults(results, json, file);
+	if(!file)
+	{
+		cout << "Could not write \"" << outputFile << "\"" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+void setup()		//General startup actions
+{
+	util::seedRandom(uint64_t(std::time(NULL)));	//Seed the randomizer
+	enableConsoleEscapes();
+}
+
+void mainLoop()		//The main loop of the program: runs one player's session on the console, feeding it each line typed until it finishes
+{
+	playerSession_type session(allowDebugCommands, true);
+	session.start();
+
+	string line;		//The last line typed, kept between lines so reading one doesn't allocate
+	while(true)
+	{
+		string & output = session.getOutput();
+		writeToConsole(output.data(), output.size());
+		output.clear();
+
+		if(session.isFinished()) break;
+		if(!getline(cin, line)) break;		//The input has closed, so nothing more can be played
+		session.feed(line);
+	}
 }
 
-int main()
+int main(int argc, char * argv[])
 {
+#ifdef BENCHMARK_MAIN
+	return runBenchmarkMode(argc, argv);		//The standalone benchmark build (make battleship-bench) never starts the game
+#endif
+	if(argc > 1 && argv[1] == std::string_view("--benchmark")) return runBenchmarkMode(argc, argv);
+	if(argc > 1 && argv[1] == std::string_view("--serve")) return runServerMode(argc, argv);
+	if(argc > 1 && argv[1] == std::string_view("--loadtest")) return runLoadTest(argc, argv);
+	if(argc > 1 && argv[1] == std::string_view("--tournament")) return runTournamentMode(argc, argv);
+	if(argc > 1) return runBatchMode(argc, argv);		//Batch mode doesn't use the console at all
+
 	setup();
 
 	mainLoop();
+
+	if(profiling::enabled) profiling::report(cout);		//Left on screen when the game closes, so the timings for the whole session can be read
 }
\ No newline at end of file